@@ -0,0 +1,62 @@
+#include "alloc_counter.hpp"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <sys/resource.h>
+
+#ifdef FORMAT_ENABLE_PROFILING
+#include "profile.hpp"
+
+// Profiling builds already replace operator new, counting per thread;
+// the benchmarks run on the main thread.
+AllocCounts alloc_counts() noexcept {
+    const auto counts = thread_alloc_counts();
+    return {counts.allocations, counts.bytes};
+}
+#else
+namespace {
+    std::atomic<uint64_t> g_allocations{0};
+    std::atomic<uint64_t> g_bytes{0};
+
+    void *allocate(std::size_t size, std::size_t align) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+        g_bytes.fetch_add(size, std::memory_order_relaxed);
+
+        if (size == 0) size = 1;
+        void *p = align > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                      ? std::aligned_alloc(align, (size + align - 1) / align * align)
+                      : std::malloc(size);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+}
+
+AllocCounts alloc_counts() noexcept {
+    return {g_allocations.load(std::memory_order_relaxed), g_bytes.load(std::memory_order_relaxed)};
+}
+
+#endif
+
+uint64_t peak_rss() noexcept {
+    rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes on Linux
+}
+
+#ifndef FORMAT_ENABLE_PROFILING
+void *operator new(std::size_t size) { return allocate(size, 0); }
+void *operator new[](std::size_t size) { return allocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t align) { return allocate(size, static_cast<std::size_t>(align)); }
+void *operator new[](std::size_t size, std::align_val_t align) { return allocate(size, static_cast<std::size_t>(align)); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
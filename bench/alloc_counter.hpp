@@ -0,0 +1,28 @@
+#ifndef FORMAT_BENCH_ALLOC_COUNTER_HPP
+#define FORMAT_BENCH_ALLOC_COUNTER_HPP
+
+#include <cstdint>
+
+// ============================================================
+// Allocation Counter
+// ============================================================
+//
+// Linking alloc_counter.cpp replaces the global operator new/delete
+// with versions that count every allocation made through them, from
+// any thread.
+
+struct AllocCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+
+    friend AllocCounts operator-(AllocCounts a, AllocCounts b) noexcept {
+        return {a.allocations - b.allocations, a.bytes - b.bytes};
+    }
+};
+
+AllocCounts alloc_counts() noexcept;
+
+// Peak resident set size of the process so far, in bytes.
+uint64_t peak_rss() noexcept;
+
+#endif // FORMAT_BENCH_ALLOC_COUNTER_HPP
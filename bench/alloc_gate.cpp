@@ -0,0 +1,146 @@
+#include "alloc_gate.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    // Just enough JSON for the baseline file: objects, strings without
+    // escapes and numbers.
+    class Reader {
+    public:
+        explicit Reader(std::string text) : m_text(std::move(text)) {}
+
+        bool consume(char c) {
+            skip_space();
+            if (m_pos < m_text.size() && m_text[m_pos] == c) {
+                ++m_pos;
+                return true;
+            }
+            return false;
+        }
+
+        std::optional<std::string> string() {
+            if (!consume('"')) return std::nullopt;
+            const auto end = m_text.find('"', m_pos);
+            if (end == std::string::npos) return std::nullopt;
+            std::string s = m_text.substr(m_pos, end - m_pos);
+            m_pos = end + 1;
+            return s;
+        }
+
+        std::optional<double> number() {
+            skip_space();
+            const char *begin = m_text.c_str() + m_pos;
+            char *end = nullptr;
+            const double v = std::strtod(begin, &end);
+            if (end == begin) return std::nullopt;
+            m_pos += static_cast<std::size_t>(end - begin);
+            return v;
+        }
+
+    private:
+        void skip_space() {
+            while (m_pos < m_text.size() && std::isspace(static_cast<unsigned char>(m_text[m_pos]))) ++m_pos;
+        }
+
+        std::string m_text;
+        std::size_t m_pos = 0;
+    };
+
+    bool read_entry(Reader &in, AllocEntry &entry) {
+        if (!in.consume('{')) return false;
+        do {
+            const auto key = in.string();
+            if (!key || !in.consume(':')) return false;
+            const auto value = in.number();
+            if (!value) return false;
+            if (*key == "allocs_per_mb") entry.allocs_per_mb = *value;
+            else if (*key == "bytes_per_mb") entry.bytes_per_mb = *value;
+        } while (in.consume(','));
+        return in.consume('}');
+    }
+}
+
+std::optional<AllocBaseline> read_alloc_baseline(const std::string &path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return std::nullopt;
+    Reader in(std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()});
+
+    AllocBaseline baseline;
+    if (!in.consume('{')) return std::nullopt;
+    do {
+        const auto key = in.string();
+        if (!key || !in.consume(':')) return std::nullopt;
+
+        if (*key == "tolerance") {
+            const auto v = in.number();
+            if (!v) return std::nullopt;
+            baseline.tolerance = *v;
+        } else if (*key == "stages") {
+            if (!in.consume('{')) return std::nullopt;
+            if (in.consume('}')) continue;
+            do {
+                AllocEntry entry;
+                const auto name = in.string();
+                if (!name || !in.consume(':') || !read_entry(in, entry)) return std::nullopt;
+                entry.name = *name;
+                baseline.entries.push_back(std::move(entry));
+            } while (in.consume(','));
+            if (!in.consume('}')) return std::nullopt;
+        } else {
+            return std::nullopt;
+        }
+    } while (in.consume(','));
+
+    if (!in.consume('}')) return std::nullopt;
+    return baseline;
+}
+
+bool write_alloc_baseline(const std::string &path, const AllocBaseline &baseline) {
+    std::FILE *f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+
+    std::fprintf(f, "{\n  \"tolerance\": %.2f,\n  \"stages\": {", baseline.tolerance);
+    for (std::size_t i = 0; i < baseline.entries.size(); ++i) {
+        const auto &e = baseline.entries[i];
+        std::fprintf(f, "%s\n    \"%s\": {\"allocs_per_mb\": %.0f, \"bytes_per_mb\": %.0f}",
+                     i ? "," : "", e.name.c_str(), e.allocs_per_mb, e.bytes_per_mb);
+    }
+    std::fprintf(f, "\n  }\n}\n");
+    return std::fclose(f) == 0;
+}
+
+bool check_allocations(const AllocBaseline &baseline, const std::vector<AllocEntry> &measured, std::FILE *out) {
+    bool ok = true;
+
+    // A baseline of zero still allows the odd allocation per MB.
+    const auto limit = [&](double base, double slack) { return base * (1 + baseline.tolerance) + slack; };
+
+    for (const auto &m : measured) {
+        const auto it = std::ranges::find(baseline.entries, m.name, &AllocEntry::name);
+        if (it == baseline.entries.end()) {
+            std::fprintf(out, "%-28s no baseline\n", m.name.c_str());
+            ok = false;
+            continue;
+        }
+
+        const bool allocs_ok = m.allocs_per_mb <= limit(it->allocs_per_mb, 1);
+        const bool bytes_ok = m.bytes_per_mb <= limit(it->bytes_per_mb, 1024);
+        const bool improved = m.allocs_per_mb < it->allocs_per_mb * (1 - baseline.tolerance) - 1 ||
+                              m.bytes_per_mb < it->bytes_per_mb * (1 - baseline.tolerance) - 1024;
+
+        std::fprintf(out, "%-28s allocs/MB %12.0f (baseline %12.0f)  bytes/MB %14.0f (baseline %14.0f)  %s\n",
+                     m.name.c_str(), m.allocs_per_mb, it->allocs_per_mb, m.bytes_per_mb, it->bytes_per_mb,
+                     !(allocs_ok && bytes_ok) ? "REGRESSED" : improved ? "improved: update the baseline" : "ok");
+        ok = ok && allocs_ok && bytes_ok;
+    }
+
+    for (const auto &b : baseline.entries)
+        if (std::ranges::find(measured, b.name, &AllocEntry::name) == measured.end())
+            std::fprintf(out, "%-28s in the baseline but not measured\n", b.name.c_str());
+
+    return ok;
+}
@@ -0,0 +1,48 @@
+#ifndef FORMAT_BENCH_ALLOC_GATE_HPP
+#define FORMAT_BENCH_ALLOC_GATE_HPP
+
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================
+// Allocation Gate
+// ============================================================
+//
+// Allocation counts, unlike timings, are the same from run to run, so
+// they can be checked in. Each entry is a stage on a corpus, normalized
+// per MB of input. check_allocations() fails an entry that exceeds its
+// baseline by more than the tolerance, and mentions entries that have
+// dropped well below theirs, so the baseline can be tightened.
+//
+// The baseline is a small JSON file:
+//
+//   {
+//     "tolerance": 0.10,
+//     "stages": {
+//       "tokenize/realistic": {"allocs_per_mb": 2, "bytes_per_mb": 31457280},
+//       ...
+//     }
+//   }
+
+struct AllocEntry {
+    std::string name;
+    double allocs_per_mb = 0;
+    double bytes_per_mb = 0;
+};
+
+struct AllocBaseline {
+    double tolerance = 0.10;
+    std::vector<AllocEntry> entries;
+};
+
+std::optional<AllocBaseline> read_alloc_baseline(const std::string &path);
+
+bool write_alloc_baseline(const std::string &path, const AllocBaseline &baseline);
+
+// Prints a line per entry to `out`; true when nothing regressed.
+bool check_allocations(const AllocBaseline &baseline, const std::vector<AllocEntry> &measured, std::FILE *out);
+
+#endif // FORMAT_BENCH_ALLOC_GATE_HPP
@@ -0,0 +1,83 @@
+#ifndef FORMAT_BENCH_BENCH_HPP
+#define FORMAT_BENCH_BENCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alloc_counter.hpp"
+
+// ============================================================
+// Benchmark Harness
+// ============================================================
+//
+// A small harness in the manner of Google Benchmark: a benchmark body
+// runs in a loop, doubling the iteration count until a run takes at
+// least the minimum time, and the last run is reported per iteration.
+// Inputs are prepared outside the loop, so only the stage under test
+// is measured, including freeing what it returns.
+
+// Keeps the compiler from discarding a result.
+template<typename T>
+inline void keep(const T &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct BenchStats {
+    std::string name;
+    uint64_t iterations = 0;
+    double seconds = 0;        // per iteration
+    double allocations = 0;    // per iteration
+    double alloc_bytes = 0;    // per iteration
+};
+
+template<typename Body>
+BenchStats run_benchmark(std::string name, double min_seconds, Body &&body) {
+    using clock = std::chrono::steady_clock;
+
+    body(); // warm-up
+
+    for (uint64_t n = 1;; n *= 2) {
+        const auto allocs = alloc_counts();
+        const auto start = clock::now();
+        for (uint64_t i = 0; i < n; ++i) body();
+        const double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+        const auto used = alloc_counts() - allocs;
+
+        if (elapsed >= min_seconds || n >= (uint64_t{1} << 30)) {
+            const auto per = static_cast<double>(n);
+            return {std::move(name), n, elapsed / per,
+                    static_cast<double>(used.allocations) / per, static_cast<double>(used.bytes) / per};
+        }
+    }
+}
+
+// ============================================================
+// Report
+// ============================================================
+
+class BenchReport {
+public:
+    void header() const {
+        std::printf("%-36s %10s %12s %10s %10s %12s %12s\n",
+                    "benchmark", "iters", "time/iter", "MB/s", "Mlines/s", "allocs/iter", "alloc MB/it");
+    }
+
+    void row(const BenchStats &s, std::size_t bytes, std::size_t lines) const {
+        const double mb = static_cast<double>(bytes) / 1e6;
+        std::printf("%-36s %10llu %10.3fms %10.1f %10.2f %12.0f %12.2f\n",
+                    s.name.c_str(), static_cast<unsigned long long>(s.iterations), s.seconds * 1e3,
+                    mb / s.seconds, static_cast<double>(lines) / 1e6 / s.seconds,
+                    s.allocations, s.alloc_bytes / 1e6);
+    }
+
+    void peak() const {
+        std::printf("%-36s %.1f MB\n", "peak RSS", static_cast<double>(peak_rss()) / 1e6);
+    }
+};
+
+#endif // FORMAT_BENCH_BENCH_HPP
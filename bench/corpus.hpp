@@ -0,0 +1,86 @@
+#ifndef FORMAT_BENCH_CORPUS_HPP
+#define FORMAT_BENCH_CORPUS_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// ============================================================
+// Benchmark Corpora
+// ============================================================
+
+// A module as it might appear in a real code base, repeated with
+// renamed units until the text reaches `size` bytes.
+inline std::string realistic_corpus(std::size_t size) {
+    static constexpr std::string_view unit = R"(!> Finite-difference helpers.
+module stencil_@
+  use iso_fortran_env, only: real64, int32
+  implicit none
+  private
+  public :: apply_@, norm_@
+
+  integer, parameter :: dp = real64
+  real(dp), parameter :: coeff(3) = [ -0.5_dp, 0.0_dp, 0.5_dp ]
+
+  type :: grid_@
+     integer :: nx, ny
+     real(dp), allocatable :: u(:,:), v(:,:)
+  end type grid_@
+
+contains
+
+  subroutine apply_@(g, dt, status)
+    type(grid_@), intent(inout) :: g
+    real(dp), intent(in) :: dt
+    integer, intent(out) :: status
+    integer :: i, j
+
+    status = 0
+    if (.not. allocated(g%u)) then
+       status = 1
+       return
+    end if
+
+    do j = 2, g%ny - 1
+       do i = 2, g%nx - 1
+          ! centred difference in both directions
+          g%v(i, j) = g%u(i, j) + dt * ( coeff(1)*g%u(i-1, j) + coeff(3)*g%u(i+1, j) &
+               + coeff(1)*g%u(i, j-1) + coeff(3)*g%u(i, j+1) )
+       end do
+    end do
+
+    select case (g%nx)
+    case (1)
+       g%v(1, :) = 0.0_dp
+    case default
+       g%v(1, :) = g%v(2, :)
+       g%v(g%nx, :) = g%v(g%nx-1, :)
+    end select
+  end subroutine apply_@
+
+  pure function norm_@(g) result(r)
+    type(grid_@), intent(in) :: g
+    real(dp) :: r
+    r = sqrt(sum(g%v**2)) / real(g%nx * g%ny, dp)
+  end function norm_@
+
+end module stencil_@
+
+)";
+
+    std::string out;
+    out.reserve(size + unit.size() * 2);
+    for (std::size_t n = 0; out.size() < size; ++n) {
+        const std::string tag = std::to_string(n);
+        for (std::size_t at = 0;;) {
+            const auto hole = unit.find('@', at);
+            out.append(unit.substr(at, hole - at));
+            if (hole == std::string_view::npos) break;
+            out += tag;
+            at = hole + 1;
+        }
+    }
+    return out;
+}
+
+#endif // FORMAT_BENCH_CORPUS_HPP
@@ -0,0 +1,287 @@
+#ifndef FORMAT_BENCH_CORPUS_GEN_HPP
+#define FORMAT_BENCH_CORPUS_GEN_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+// ============================================================
+// Synthetic Corpus Generator
+// ============================================================
+//
+// Emits valid free-form Fortran, deterministically from a seed: the
+// same options give the same bytes on every platform (the generator
+// uses its own PRNG, not <random>'s distributions). Output is made of
+// units, a module of procedures and, now and then, a program using it;
+// together they produce every NodeKind the classifier knows. Shape is
+// set by the options: how deep do/if/select case nest, how long '&'
+// continuation chains run, how many lines are comments and how wide
+// declaration lists are. With `messy`, indentation, spacing and keyword
+// case are scrambled so the formatter has work to do.
+//
+// Text is handed to the sink in chunks, so inputs far larger than
+// memory can be streamed to a file.
+
+struct CorpusOptions {
+    uint64_t seed = 1;
+    std::size_t size = std::size_t{1} << 20; // bytes; the last unit is finished past it
+    int max_depth = 6;                       // nested do / if / select case
+    int max_continuations = 8;               // '&' lines in one statement
+    int comment_percent = 10;                // of statements preceded by a comment
+    int declaration_width = 16;              // names in one declaration
+    bool messy = true;
+};
+
+class CorpusGenerator {
+public:
+    using Sink = std::function<void(std::string_view)>;
+
+    explicit CorpusGenerator(CorpusOptions options) : m_options(options), m_state(options.seed) {}
+
+    void generate(const Sink &sink) {
+        m_sink = &sink;
+        for (std::size_t unit = 0; m_written + m_buffer.size() < m_options.size; ++unit) {
+            module_unit(unit);
+            if (unit % 4 == 3) program_unit(unit);
+            if (m_buffer.size() >= chunk) flush();
+        }
+        flush();
+        m_sink = nullptr;
+    }
+
+    [[nodiscard]] std::size_t written() const noexcept { return m_written; }
+
+private:
+    static constexpr std::size_t chunk = std::size_t{1} << 20;
+
+    // ---- randomness ------------------------------------------------
+
+    // splitmix64
+    uint64_t next() noexcept {
+        uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    int below(int n) noexcept { return n <= 0 ? 0 : static_cast<int>(next() % static_cast<uint64_t>(n)); }
+    bool percent(int p) noexcept { return below(100) < p; }
+
+    // ---- output ----------------------------------------------------
+
+    void flush() {
+        if (m_buffer.empty()) return;
+        (*m_sink)(m_buffer);
+        m_written += m_buffer.size();
+        m_buffer.clear();
+    }
+
+    void indent(int depth) {
+        const int n = m_options.messy ? below(4) == 0 ? below(9) : depth * 2 + below(2) : depth * 2;
+        m_buffer.append(static_cast<std::size_t>(n), ' ');
+    }
+
+    // Keywords come in lower case; messy output recases some lines.
+    void line(int depth, std::string_view text) {
+        indent(depth);
+        const std::size_t at = m_buffer.size();
+        m_buffer += text;
+        if (m_options.messy && text.find('\'') == std::string_view::npos && below(8) == 0)
+            for (std::size_t i = at; i < m_buffer.size(); ++i)
+                if (m_buffer[i] >= 'a' && m_buffer[i] <= 'z') m_buffer[i] = static_cast<char>(m_buffer[i] - 32);
+        m_buffer += '\n';
+    }
+
+    // ", " or "," with messy spacing
+    std::string_view comma() noexcept { return m_options.messy && below(2) ? "," : ", "; }
+    std::string_view eq() noexcept { return m_options.messy && below(2) ? "=" : " = "; }
+
+    void maybe_comment(int depth) {
+        if (!percent(m_options.comment_percent)) return;
+        static constexpr std::string_view notes[] = {
+            "! update the running total", "! guard against an empty range",
+            "!> Applies one relaxation sweep.", "! TODO: vectorise", "!! see the note above",
+        };
+        line(depth, notes[below(5)]);
+    }
+
+    // ---- declarations ----------------------------------------------
+
+    // "real(dp) :: a1, a2, ..." wrapped with '&' every few names.
+    void declaration_list(int depth, std::string_view type, std::string_view prefix) {
+        const int width = 1 + below(m_options.declaration_width);
+        std::string text = std::string(type) + " :: ";
+        for (int i = 0; i < width; ++i) {
+            if (i) {
+                text += comma();
+                if (i % 6 == 0) {
+                    text += '&';
+                    line(depth, text);
+                    text = "    ";
+                }
+            }
+            text += std::string(prefix) + std::to_string(i);
+        }
+        line(depth, text);
+    }
+
+    void locals(int depth) {
+        line(depth, "integer, intent(in) :: n");
+        line(depth, "real(dp), intent(inout) :: x(:)");
+        std::string loops = "integer :: i0";
+        for (int d = 1; d <= m_options.max_depth; ++d) loops += ", i" + std::to_string(d);
+        line(depth, loops);
+        line(depth, "real(dp) :: y, z");
+        declaration_list(depth, "real(dp)", "w");
+    }
+
+    // ---- statements ------------------------------------------------
+
+    // "y = x(i) + ..." over up to max_continuations '&' lines
+    void assignment(int depth, int loop) {
+        const std::string i = "i" + std::to_string(loop);
+        const int parts = percent(30) ? below(m_options.max_continuations + 1) : 0;
+        std::string text = "y" + std::string(eq()) + "y+x(" + i + ")*2.0_dp";
+        for (int p = 0; p < parts; ++p) {
+            text += " &";
+            line(depth, text);
+            text = "  " + std::string(below(3) == 0 ? "&" : "") + "+ w0*real(" + i + ", dp)";
+        }
+        line(depth, text);
+    }
+
+    void simple(int depth, int loop) {
+        maybe_comment(depth);
+        switch (below(8)) {
+            case 0: line(depth, "call random_number(z)"); break;
+            case 1: line(depth, "print *, 'y = ', y"); break;
+            case 2: line(depth, "if (y > 1.0e3_dp) y" + std::string(eq()) + "0.0_dp"); break;
+            case 3: line(depth, "z = max(z, y) ! keep the largest"); break;
+            case 4: line(depth, "continue"); break;
+            default: assignment(depth, loop); break;
+        }
+    }
+
+    void block(int depth, int nest, int loop) {
+        const int count = 1 + below(3);
+        for (int s = 0; s < count; ++s) {
+            if (nest < m_options.max_depth && percent(nest == 0 ? 90 : 45)) compound(depth, nest + 1, loop);
+            else simple(depth, loop);
+        }
+    }
+
+    void compound(int depth, int nest, int loop) {
+        maybe_comment(depth);
+        switch (below(3)) {
+            case 0: {
+                const std::string i = "i" + std::to_string(nest);
+                line(depth, "do " + i + std::string(eq()) + "1" + std::string(comma()) + "n");
+                block(depth + 1, nest, nest);
+                line(depth, percent(30) ? "enddo" : "end do");
+                break;
+            }
+            case 1:
+                line(depth, std::string(m_options.messy && below(2) ? "if(" : "if (") + "y < z) then");
+                block(depth + 1, nest, loop);
+                if (percent(40)) {
+                    line(depth, "else if (y > z) then");
+                    block(depth + 1, nest, loop);
+                }
+                if (percent(50)) {
+                    line(depth, "else");
+                    block(depth + 1, nest, loop);
+                }
+                line(depth, percent(30) ? "endif" : "end if");
+                break;
+            default:
+                line(depth, "select case (mod(n, 3))");
+                line(depth, "case (0)");
+                block(depth + 1, nest, loop);
+                line(depth, "case (1, 2)");
+                block(depth + 1, nest, loop);
+                line(depth, "case default");
+                simple(depth + 1, loop);
+                line(depth, "end select");
+                break;
+        }
+    }
+
+    // ---- units -----------------------------------------------------
+
+    void module_unit(std::size_t unit) {
+        const std::string k = std::to_string(unit);
+
+        line(0, "!> Generated module " + k + ".");
+        line(0, "module m" + k);
+        line(1, "use iso_fortran_env, only: real64");
+        line(1, "implicit none");
+        line(1, "integer, parameter :: dp = real64");
+        m_buffer += '\n';
+
+        line(1, "type :: t" + k);
+        line(2, "integer :: n");
+        declaration_list(2, "real(dp)", "c");
+        line(1, "end type t" + k);
+        line(1, "type, extends(t" + k + ") :: u" + k);
+        line(2, "type(t" + k + ") :: inner");
+        line(1, "end type u" + k);
+        m_buffer += '\n';
+
+        line(1, "interface g" + k);
+        line(2, "module procedure s" + k);
+        line(1, "end interface g" + k);
+        m_buffer += '\n';
+
+        line(0, "contains");
+        m_buffer += '\n';
+
+        line(1, "subroutine s" + k + "(n, x)");
+        locals(2);
+        line(2, "y = 0.0_dp");
+        line(2, "z = 0.0_dp");
+        line(2, "w0 = 1.0_dp");
+        block(2, 0, 0);
+        line(2, "x(1) = y");
+        line(1, "end subroutine s" + k);
+        m_buffer += '\n';
+
+        line(1, "pure function f" + k + "(x) result(r)");
+        line(2, "real(dp), intent(in) :: x(:)");
+        line(2, "real(dp) :: r");
+        line(2, "r = sum(x)/real(size(x), dp)");
+        line(1, "end function f" + k);
+        line(0, "end module m" + k);
+        m_buffer += '\n';
+    }
+
+    void program_unit(std::size_t unit) {
+        const std::string k = std::to_string(unit);
+
+        line(0, "program p" + k);
+        line(1, "use m" + k);
+        line(1, "implicit none");
+        line(1, "real(dp) :: v(8)");
+        line(1, "v = 1.0_dp");
+        line(1, "call s" + k + "(size(v), v)");
+        line(1, "print *, f" + k + "(v)");
+        line(0, "end program p" + k);
+        m_buffer += '\n';
+    }
+
+    CorpusOptions m_options;
+    uint64_t m_state;
+    const Sink *m_sink = nullptr;
+    std::string m_buffer;
+    std::size_t m_written = 0;
+};
+
+inline std::string generate_corpus(const CorpusOptions &options) {
+    std::string out;
+    out.reserve(options.size + (options.size >> 4));
+    CorpusGenerator(options).generate([&](std::string_view text) { out += text; });
+    return out;
+}
+
+#endif // FORMAT_BENCH_CORPUS_GEN_HPP
@@ -0,0 +1,69 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "corpus_gen.hpp"
+
+// Writes a synthetic corpus to a file or standard output:
+//
+//   format_corpus [--seed=N] [--size=N[K|M|G]] [--depth=N] [--continuations=N]
+//                 [--comments=PERCENT] [--width=N] [--tidy] [-o FILE]
+
+namespace {
+    [[noreturn]] void usage(const char *argv0) {
+        std::fprintf(stderr,
+                     "usage: %s [--seed=N] [--size=N[K|M|G]] [--depth=N] [--continuations=N]\n"
+                     "          [--comments=PERCENT] [--width=N] [--tidy] [-o FILE]\n", argv0);
+        std::exit(2);
+    }
+
+    std::size_t parse_size(std::string_view text) {
+        char *end = nullptr;
+        std::size_t n = std::strtoull(std::string(text).c_str(), &end, 10);
+        switch (*end) {
+            case 'G': case 'g': n <<= 10; [[fallthrough]];
+            case 'M': case 'm': n <<= 10; [[fallthrough]];
+            case 'K': case 'k': n <<= 10; break;
+            default: break;
+        }
+        return n;
+    }
+}
+
+int main(int argc, char **argv) {
+    CorpusOptions options;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const auto value = [&](std::string_view flag) { return arg.substr(flag.size()); };
+
+        if (arg.starts_with("--seed=")) options.seed = std::strtoull(argv[i] + 7, nullptr, 10);
+        else if (arg.starts_with("--size=")) options.size = parse_size(value("--size="));
+        else if (arg.starts_with("--depth=")) options.max_depth = std::atoi(argv[i] + 8);
+        else if (arg.starts_with("--continuations=")) options.max_continuations = std::atoi(argv[i] + 16);
+        else if (arg.starts_with("--comments=")) options.comment_percent = std::atoi(argv[i] + 11);
+        else if (arg.starts_with("--width=")) options.declaration_width = std::atoi(argv[i] + 8);
+        else if (arg == "--tidy") options.messy = false;
+        else if (arg == "-o" && i + 1 < argc) output = argv[++i];
+        else usage(argv[0]);
+    }
+
+    std::ofstream file;
+    if (!output.empty()) {
+        file.open(output, std::ios::binary);
+        if (!file) {
+            std::fprintf(stderr, "%s: cannot write %s\n", argv[0], output.c_str());
+            return 1;
+        }
+    }
+    std::ostream &out = output.empty() ? std::cout : file;
+
+    CorpusGenerator(options).generate([&](std::string_view text) {
+        out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    });
+    return out ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "alloc_gate.hpp"
+#include "bench.hpp"
+#include "corpus.hpp"
+#include "corpus_gen.hpp"
+
+#include "block_tree.hpp"
+#include "cst.hpp"
+#include "cst_visitor.hpp"
+#include "fused_pipeline.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+
+// Benchmarks each stage of the pipeline on its own, over several
+// corpora and sizes:
+//
+//   format_bench [--filter=<substring>] [--min-time=<seconds>] [--max-size=<MB>]
+//
+// or checks the allocations of each stage against a baseline (see
+// alloc_gate.hpp), or writes a new baseline:
+//
+//   format_bench --alloc-gate=<baseline.json>
+//   format_bench --write-alloc-baseline=<baseline.json>
+
+namespace {
+    struct Options {
+        std::string filter;
+        double min_time = 0.5;
+        double max_size_mb = 16;
+        std::string alloc_gate;     // baseline to check allocations against
+        std::string write_baseline; // where to write a fresh baseline
+    };
+
+    [[noreturn]] void usage(const char *argv0) {
+        std::fprintf(stderr,
+                     "usage: %s [--filter=S] [--min-time=SECONDS] [--max-size=MB]\n"
+                     "       %s --alloc-gate=BASELINE.json\n"
+                     "       %s --write-alloc-baseline=BASELINE.json\n", argv0, argv0, argv0);
+        std::exit(2);
+    }
+
+    Options parse_options(int argc, char **argv) {
+        Options options;
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            if (arg.starts_with("--filter=")) options.filter = arg.substr(9);
+            else if (arg.starts_with("--min-time=")) options.min_time = std::atof(argv[i] + 11);
+            else if (arg.starts_with("--max-size=")) options.max_size_mb = std::atof(argv[i] + 11);
+            else if (arg.starts_with("--alloc-gate=")) options.alloc_gate = arg.substr(13);
+            else if (arg.starts_with("--write-alloc-baseline=")) options.write_baseline = arg.substr(23);
+            else usage(argv[0]);
+        }
+        return options;
+    }
+
+    // The stages of the pipeline over one source, each with its input
+    // prepared up front.
+    class Stages {
+    public:
+        explicit Stages(const std::string &source)
+            : m_source(source), m_tz(source), m_tokens(m_tz.tokenize()),
+              m_lines(UnwrappedLineParser(m_tokens).parse()), m_cst(build_cst(m_lines)) {}
+
+        // Calls f(name, body) for each stage; `all` adds the stages that
+        // only repeat others' work.
+        template<typename F>
+        void for_each(F &&f, bool all = true) const {
+            f("tokenize", [&] {
+                FortranTokenizer t(m_source);
+                keep(t.tokenize());
+            });
+
+            f("parse", [&] {
+                keep(UnwrappedLineParser(m_tokens).parse());
+            });
+
+            if (all) f("classify", [&] {
+                for (const auto &line : m_lines) keep(classify(line));
+            });
+
+            f("build_cst", [&] {
+                keep(build_cst(m_lines));
+            });
+
+            f("block_tree", [&] {
+                BlockTreeBuilder builder;
+                for (const auto &node : m_cst) builder.on_node(node);
+                keep(builder.root);
+            });
+
+            if (all) f("pipeline", [&] {
+                FortranTokenizer t(m_source);
+                const auto ts = t.tokenize();
+                const auto ls = UnwrappedLineParser(ts).parse();
+                BlockTreeBuilder builder;
+                keep(build_cst(ls, &builder));
+            });
+
+            // The fused pipeline's lines do not outlive on_node, so its
+            // tree is the flat one, which keeps indices only.
+            if (all) f("fused", [&] {
+                FlatBlockTreeBuilder builder;
+                FusedPipeline(builder).run(m_source);
+                keep(builder.tree);
+            });
+        }
+
+    private:
+        const std::string &m_source;
+        FortranTokenizer m_tz;
+        std::vector<Token> m_tokens;
+        std::vector<UnwrappedLine> m_lines;
+        std::vector<CSTNode> m_cst;
+    };
+
+    void bench_corpus(const Options &options, const BenchReport &report,
+                      std::string_view corpus, const std::string &source) {
+        const std::size_t bytes = source.size();
+        const std::size_t physical = static_cast<std::size_t>(std::ranges::count(source, '\n'));
+        const std::string suffix = "/" + std::string(corpus) + "/" + std::to_string(bytes >> 10) + "K";
+
+        Stages(source).for_each([&](std::string_view stage, auto &&body) {
+            const std::string name = std::string(stage) + suffix;
+            if (!options.filter.empty() && !name.contains(options.filter)) return;
+            report.row(run_benchmark(name, options.min_time, body), bytes, physical);
+        });
+    }
+
+    // Allocations of one run of each stage, per MB of input. The corpora
+    // are fixed, so the numbers only move when the code does.
+    std::vector<AllocEntry> measure_allocations() {
+        std::vector<AllocEntry> out;
+
+        const auto measure = [&](std::string_view corpus, const std::string &source) {
+            const double mb = static_cast<double>(source.size()) / (1 << 20);
+            Stages(source).for_each([&](std::string_view stage, auto &&body) {
+                const auto before = alloc_counts();
+                body();
+                const auto used = alloc_counts() - before;
+                out.push_back({std::string(stage) + "/" + std::string(corpus),
+                               static_cast<double>(used.allocations) / mb, static_cast<double>(used.bytes) / mb});
+            }, false);
+        };
+
+        measure("realistic", realistic_corpus(1 << 20));
+        measure("synthetic", generate_corpus({.seed = 1, .size = 1 << 20}));
+        return out;
+    }
+}
+
+int main(int argc, char **argv) {
+    const Options options = parse_options(argc, argv);
+
+    if (!options.write_baseline.empty()) {
+        if (!write_alloc_baseline(options.write_baseline, {.entries = measure_allocations()})) {
+            std::fprintf(stderr, "cannot write %s\n", options.write_baseline.c_str());
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!options.alloc_gate.empty()) {
+        const auto baseline = read_alloc_baseline(options.alloc_gate);
+        if (!baseline) {
+            std::fprintf(stderr, "cannot read %s\n", options.alloc_gate.c_str());
+            return 1;
+        }
+        return check_allocations(*baseline, measure_allocations(), stdout) ? 0 : 1;
+    }
+
+    const BenchReport report;
+    report.header();
+    for (const std::size_t kb : {64uz, 1024uz, 16384uz}) {
+        if (static_cast<double>(kb) / 1024.0 > options.max_size_mb) continue;
+        bench_corpus(options, report, "realistic", realistic_corpus(kb << 10));
+        bench_corpus(options, report, "synthetic", generate_corpus({.size = kb << 10}));
+    }
+    report.peak();
+}
@@ -0,0 +1,105 @@
+#ifndef FORMAT_ARENA_HPP
+#define FORMAT_ARENA_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// ============================================================
+// Per-file Arena
+// ============================================================
+//
+// A monotonic memory resource for everything built from one file: the
+// token vector, the Tokens of each UnwrappedLine, the CSTNode vector and
+// the BlockTreeBuilder nodes. Nothing is freed individually; reset()
+// drops it all at once.
+//
+//     FileArena arena;
+//     for (const auto &path : paths) {
+//         auto source = SourceBuffer::from_file(path);
+//         arena.reset(FileArena::estimate(source.size()));
+//         auto tokens = FortranTokenizer(source).tokenize(arena.resource());
+//         auto lines = UnwrappedLineParser(tokens).parse(arena.resource());
+//         BlockTreeBuilder tree(arena.resource());
+//         auto cst = build_cst(lines, &tree, arena.resource());
+//         ...
+//     }   // all of it must be gone before the next reset()
+//
+// The arena keeps its block between files and grows it to cover what the
+// previous file spilled, so a batch of similar files settles into one
+// allocation. Only up to `retain_limit` bytes are kept, though: a block
+// made bigger for one large file is given back at the next reset() that
+// does not need it. Not thread-safe; use one arena per thread.
+
+class FileArena {
+public:
+    static constexpr std::size_t default_retain_limit = 64 << 20;
+
+    explicit FileArena(std::size_t initial_size = 64 * 1024,
+                       std::size_t retain_limit = default_retain_limit)
+        : m_retain_limit(retain_limit) {
+        reset(initial_size);
+    }
+
+    FileArena(const FileArena &) = delete;
+    FileArena &operator=(const FileArena &) = delete;
+
+    // Rough upper bound on the bytes one file of this size needs.
+    static constexpr std::size_t estimate(std::size_t source_size) noexcept {
+        return 4096 + source_size * 24;
+    }
+
+    // Frees everything allocated so far and makes at least `size` bytes
+    // available without going back to the system. A block above the
+    // retain limit shrinks to what is wanted now.
+    void reset(std::size_t size = 0) {
+        m_resource.reset();
+
+        const std::size_t grown = std::min(m_capacity + m_upstream.spilled, m_retain_limit);
+        const std::size_t wanted = std::max(size, grown);
+        if (wanted > m_capacity || m_capacity > std::max(wanted, m_retain_limit)) {
+            m_block = std::make_unique_for_overwrite<std::byte[]>(wanted);
+            m_capacity = wanted;
+        }
+        m_upstream.spilled = 0;
+
+        m_resource.emplace(m_block.get(), m_capacity, &m_upstream);
+    }
+
+    [[nodiscard]] std::pmr::memory_resource *resource() noexcept { return &*m_resource; }
+
+    // Size of the block reused from file to file.
+    [[nodiscard]] std::size_t capacity() const noexcept { return m_capacity; }
+
+    // Bytes requested beyond the block since the last reset().
+    [[nodiscard]] std::size_t spilled() const noexcept { return m_upstream.spilled; }
+
+private:
+    // Counts what the arena takes from the heap once its block is full.
+    struct Upstream : std::pmr::memory_resource {
+        std::size_t spilled = 0;
+
+        void *do_allocate(std::size_t bytes, std::size_t align) override {
+            spilled += bytes;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+
+        void do_deallocate(void *p, std::size_t bytes, std::size_t align) override {
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+
+        [[nodiscard]] bool do_is_equal(const memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+    };
+
+    std::unique_ptr<std::byte[]> m_block;
+    std::size_t m_capacity = 0;
+    std::size_t m_retain_limit;
+    Upstream m_upstream;
+    std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+};
+
+#endif // FORMAT_ARENA_HPP
@@ -0,0 +1,116 @@
+#include "batch.hpp"
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+
+#include "arena.hpp"
+#include "format_cache.hpp"
+#include "source_buffer.hpp"
+#include "thread_pool.hpp"
+
+namespace {
+    // Reports finished files in input order.
+    class OrderedReporter {
+    public:
+        OrderedReporter(std::vector<BatchResult> &results, const BatchReport &report, bool keep_output)
+            : m_results(results), m_report(report), m_keep_output(keep_output),
+              m_done(results.size(), false) {}
+
+        void finished(std::size_t i) {
+            if (!m_report) {
+                if (!m_keep_output) m_results[i].output = std::string();
+                return;
+            }
+
+            std::lock_guard lock(m_mutex);
+            m_done[i] = true;
+            while (m_next < m_done.size() && m_done[m_next]) {
+                BatchResult &result = m_results[m_next++];
+                m_report(result);
+                if (!m_keep_output) result.output = std::string();
+            }
+        }
+
+    private:
+        std::vector<BatchResult> &m_results;
+        const BatchReport &m_report;
+        bool m_keep_output;
+        std::mutex m_mutex;
+        std::vector<bool> m_done;
+        std::size_t m_next = 0;
+    };
+}
+
+std::vector<BatchResult> format_files(std::span<const std::filesystem::path> paths,
+                                      const BatchOptions &options,
+                                      const BatchReport &report) {
+    std::vector<BatchResult> results(paths.size());
+    if (paths.empty()) return results;
+
+    unsigned threads = options.threads ? options.threads : std::thread::hardware_concurrency();
+    threads = std::clamp<unsigned>(threads, 1, static_cast<unsigned>(paths.size()));
+
+    WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<FileArena>> arenas;
+    for (unsigned w = 0; w < pool.size(); ++w)
+        arenas.push_back(std::make_unique<FileArena>());
+
+    const FortranFormatter formatter(options.format);
+    OrderedReporter reporter(results, report, options.keep_output);
+
+    std::optional<FormatCache> cache;
+    if (!options.cache.empty()) cache.emplace(options.cache, options.format);
+
+    const WorkStealingPool::Task task = [&](unsigned worker, uint32_t i) {
+        BatchResult &result = results[i];
+        result.path = paths[i];
+
+        try {
+            const auto source = SourceBuffer::from_file(paths[i]);
+
+            if (auto hit = cache ? cache->lookup(source.view()) : std::nullopt) {
+                result.changed = hit->changed;
+                result.output = std::move(hit->output);
+                result.cached = true;
+            } else {
+                result.output = formatter.format(source.view(), *arenas[worker]);
+                result.changed = result.output != source.view();
+                if (cache) cache->store(source.view(), result.output);
+                if (!result.changed) result.output = std::string();
+            }
+        } catch (const std::exception &e) {
+            result.output.clear();
+            result.error = e.what();
+        }
+
+        reporter.finished(i);
+    };
+
+    // Outputs that are dropped once reported wait for at most one window.
+    std::size_t window = paths.size();
+    if (!options.keep_output) window = options.window ? options.window : std::size_t{4} * threads;
+
+    std::vector<std::uintmax_t> sizes(paths.size());
+    std::vector<uint32_t> order;
+    for (std::size_t first = 0; first < paths.size(); first += window) {
+        const std::size_t last = std::min(paths.size(), first + window);
+
+        // Largest files first, so no big file is left for the end.
+        for (std::size_t i = first; i < last; ++i) {
+            std::error_code ec;
+            const auto size = std::filesystem::file_size(paths[i], ec);
+            sizes[i] = ec ? 0 : size;
+        }
+
+        order.resize(last - first);
+        std::iota(order.begin(), order.end(), static_cast<uint32_t>(first));
+        std::ranges::stable_sort(order, std::greater{}, [&](uint32_t i) { return sizes[i]; });
+
+        pool.run(order, task);
+    }
+
+    return results;
+}
@@ -0,0 +1,56 @@
+#ifndef FORMAT_BATCH_HPP
+#define FORMAT_BATCH_HPP
+
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "formatter.hpp"
+
+// ============================================================
+// Batch Formatting
+// ============================================================
+//
+// Formats many files on a WorkStealingPool. Files are scheduled largest
+// first, each worker reuses its own FileArena from file to file, and
+// results come back in the order the paths were given, whatever order
+// the workers finish them in. With a cache directory, files whose
+// contents were seen before are answered from the FormatCache.
+//
+// Only changed files carry output. With keep_output off, each output is
+// released once the report callback has seen it, and the paths are
+// formatted a window of consecutive paths at a time, largest first
+// within the window. Since a file is reported only after all the files
+// before it, this bounds the outputs waiting to be reported by the
+// window size, at the cost of some idle workers at the end of each
+// window.
+
+struct BatchOptions {
+    unsigned threads = 0; // 0: one per hardware thread
+    FormatOptions format{};
+    std::filesystem::path cache{}; // FormatCache directory; empty: no cache
+    bool keep_output = true;       // false: drop each output after reporting it
+    std::size_t window = 0;        // with keep_output off; 0: 4 paths per thread
+};
+
+struct BatchResult {
+    std::filesystem::path path;
+    std::string output;      // formatted text; empty if unchanged or on error
+    std::string error;       // what went wrong reading the file, if anything
+    bool changed = false;    // output differs from the input
+    bool cached = false;     // came from the cache, without formatting
+
+    [[nodiscard]] bool ok() const noexcept { return error.empty(); }
+};
+
+// Called once per file, in input order, as soon as the file and all the
+// files before it are done. Calls never overlap.
+using BatchReport = std::function<void(const BatchResult &)>;
+
+std::vector<BatchResult> format_files(std::span<const std::filesystem::path> paths,
+                                      const BatchOptions &options = {},
+                                      const BatchReport &report = {});
+
+#endif // FORMAT_BATCH_HPP
@@ -0,0 +1,222 @@
+#ifndef FORMAT_BLOCK_TREE_HPP
+#define FORMAT_BLOCK_TREE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+
+#include "cst_node.hpp"
+#include "cst_visitor.hpp"
+#include "profile.hpp"
+
+// ============================================================
+// Flat Block Tree
+// ============================================================
+//
+// The block structure of a file as parallel arrays indexed by block id.
+// Block 0 is a root that stands for the whole file; every construct
+// (program, subroutine, if, do, ...) is a block whose begin/end are
+// indices into the CST vector. Blocks are numbered in the order they
+// begin, so walking ids 0..size() is a preorder traversal that reads the
+// arrays front to back, and a block's descendants directly follow it.
+//
+// Unlike BlockTreeBuilder, sibling constructs are siblings here: an end
+// line closes the innermost open block. A block that is never closed
+// has end == FlatBlockTree::none, as does the root.
+
+class FlatBlockTree {
+public:
+    static constexpr uint32_t none = UINT32_MAX;
+    static constexpr uint32_t root = 0;
+
+    explicit FlatBlockTree(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_parent(resource), m_first_child(resource), m_next_sibling(resource),
+          m_begin(resource), m_end(resource) {
+        add(none, none);
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_parent.size(); }
+
+    [[nodiscard]] uint32_t parent(uint32_t b) const noexcept { return m_parent[b]; }
+    [[nodiscard]] uint32_t first_child(uint32_t b) const noexcept { return m_first_child[b]; }
+    [[nodiscard]] uint32_t next_sibling(uint32_t b) const noexcept { return m_next_sibling[b]; }
+
+    // CST node indices of the opening and closing lines.
+    [[nodiscard]] uint32_t begin(uint32_t b) const noexcept { return m_begin[b]; }
+    [[nodiscard]] uint32_t end(uint32_t b) const noexcept { return m_end[b]; }
+
+    [[nodiscard]] std::span<const uint32_t> parents() const noexcept { return m_parent; }
+    [[nodiscard]] std::span<const uint32_t> begins() const noexcept { return m_begin; }
+    [[nodiscard]] std::span<const uint32_t> ends() const noexcept { return m_end; }
+
+    // Number of enclosing blocks, not counting the root.
+    [[nodiscard]] int depth(uint32_t b) const noexcept {
+        int d = 0;
+        for (b = m_parent[b]; b != none && b != root; b = m_parent[b]) ++d;
+        return d;
+    }
+
+    class child_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = uint32_t;
+        using difference_type = std::ptrdiff_t;
+
+        child_iterator() = default;
+        child_iterator(const FlatBlockTree *tree, uint32_t b) : m_tree(tree), m_block(b) {}
+
+        uint32_t operator*() const noexcept { return m_block; }
+        child_iterator &operator++() noexcept { m_block = m_tree->next_sibling(m_block); return *this; }
+        child_iterator operator++(int) noexcept { auto it = *this; ++*this; return it; }
+        bool operator==(const child_iterator &o) const noexcept { return m_block == o.m_block; }
+
+    private:
+        const FlatBlockTree *m_tree = nullptr;
+        uint32_t m_block = none;
+    };
+
+    struct Children {
+        child_iterator first, last;
+        [[nodiscard]] child_iterator begin() const noexcept { return first; }
+        [[nodiscard]] child_iterator end() const noexcept { return last; }
+    };
+
+    [[nodiscard]] Children children(uint32_t b) const noexcept {
+        return {{this, m_first_child[b]}, {this, none}};
+    }
+
+    void reserve(std::size_t n) {
+        m_parent.reserve(n);
+        m_first_child.reserve(n);
+        m_next_sibling.reserve(n);
+        m_begin.reserve(n);
+        m_end.reserve(n);
+    }
+
+    // Building interface, used by FlatBlockTreeBuilder.
+    uint32_t add(uint32_t parent, uint32_t begin) {
+        const auto b = static_cast<uint32_t>(m_parent.size());
+        m_parent.push_back(parent);
+        m_first_child.push_back(none);
+        m_next_sibling.push_back(none);
+        m_begin.push_back(begin);
+        m_end.push_back(none);
+        return b;
+    }
+
+    void set_first_child(uint32_t b, uint32_t child) noexcept { m_first_child[b] = child; }
+    void set_next_sibling(uint32_t b, uint32_t sibling) noexcept { m_next_sibling[b] = sibling; }
+    void set_begin(uint32_t b, uint32_t begin) noexcept { m_begin[b] = begin; }
+    void set_end(uint32_t b, uint32_t end) noexcept { m_end[b] = end; }
+
+    // First id after b and its descendants.
+    [[nodiscard]] uint32_t subtree_end(uint32_t b) const noexcept {
+        for (; b != none; b = m_parent[b])
+            if (m_next_sibling[b] != none) return m_next_sibling[b];
+        return static_cast<uint32_t>(size());
+    }
+
+    // Replaces the descendants of b with those of sub's root, whose
+    // begins and ends must already be node indices of this tree. The
+    // blocks after b's subtree are renumbered, so the cost grows with
+    // their number, not with the blocks before b.
+    void replace_children(uint32_t b, const FlatBlockTree &sub) {
+        const uint32_t first = b + 1;
+        const uint32_t last = subtree_end(b);
+        const auto count = static_cast<uint32_t>(sub.size() - 1);
+
+        // Only b's ancestors and the blocks after its subtree can link
+        // past it.
+        const auto shift = [&](uint32_t x) { return x == none || x < last ? x : x - (last - first) + count; };
+        for (uint32_t a = b; a != none; a = m_parent[a]) m_next_sibling[a] = shift(m_next_sibling[a]);
+        for (uint32_t x = last; x < size(); ++x) {
+            m_parent[x] = shift(m_parent[x]);
+            m_first_child[x] = shift(m_first_child[x]);
+            m_next_sibling[x] = shift(m_next_sibling[x]);
+        }
+
+        const auto place = [b](uint32_t x) { return x == none ? none : x + b; };
+        const auto splice = [&](std::pmr::vector<uint32_t> &to, const std::pmr::vector<uint32_t> &from, bool link) {
+            to.erase(to.begin() + first, to.begin() + last);
+            const auto at = to.insert(to.begin() + first, from.begin() + 1, from.end());
+            if (link) std::transform(at, at + count, at, place);
+        };
+        splice(m_parent, sub.m_parent, true);
+        splice(m_first_child, sub.m_first_child, true);
+        splice(m_next_sibling, sub.m_next_sibling, true);
+        splice(m_begin, sub.m_begin, false);
+        splice(m_end, sub.m_end, false);
+        m_first_child[b] = place(sub.m_first_child[root]);
+    }
+
+private:
+    std::pmr::vector<uint32_t> m_parent;
+    std::pmr::vector<uint32_t> m_first_child;
+    std::pmr::vector<uint32_t> m_next_sibling;
+    std::pmr::vector<uint32_t> m_begin;
+    std::pmr::vector<uint32_t> m_end;
+};
+
+// ============================================================
+// Flat Block Tree Builder
+// ============================================================
+//
+// Visitor that fills a FlatBlockTree from build_cst; it relies on
+// CSTNode::index, not on the node's line pointer, so it works for both
+// copied and index-range lines. Appending a block needs no allocation
+// beyond the growth of the arrays.
+
+struct FlatBlockTreeBuilder : public CSTVisitor {
+    FlatBlockTree tree;
+
+    explicit FlatBlockTreeBuilder(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : tree(resource), m_last_child(resource) {
+        m_last_child.push_back(FlatBlockTree::none);
+    }
+
+    void on_node(const CSTNode& node) override {
+        const auto index = static_cast<uint32_t>(node.index);
+
+        if (BlockTreeBuilder::begins_block(node.kind)) {
+            const uint32_t b = tree.add(m_current, index);
+            m_last_child.push_back(FlatBlockTree::none);
+
+            if (m_last_child[m_current] == FlatBlockTree::none)
+                tree.set_first_child(m_current, b);
+            else
+                tree.set_next_sibling(m_last_child[m_current], b);
+            m_last_child[m_current] = b;
+
+            m_current = b;
+            on_enter(node);
+        }
+
+        else if (BlockTreeBuilder::ends_block(node.kind)) {
+            // A stray end at file level has no block to close.
+            if (m_current != FlatBlockTree::root) {
+                tree.set_end(m_current, index);
+                m_current = tree.parent(m_current);
+            }
+            on_exit(node);
+        }
+    }
+
+    // Convenience: the tree of an already built CST.
+    static FlatBlockTree build(std::span<const CSTNode> cst,
+                               std::pmr::memory_resource *resource = std::pmr::get_default_resource()) {
+        FORMAT_PROFILE_SCOPE("block_tree", "blocks");
+        FlatBlockTreeBuilder builder(resource);
+        builder.tree.reserve(cst.size() / 4 + 1);
+        for (const auto &node : cst) builder.on_node(node);
+        FORMAT_PROFILE_ITEMS(builder.tree.size());
+        return std::move(builder.tree);
+    }
+
+private:
+    uint32_t m_current = FlatBlockTree::root;
+    std::pmr::vector<uint32_t> m_last_child; // per block, for O(1) appends
+};
+
+#endif // FORMAT_BLOCK_TREE_HPP
@@ -1,118 +1,172 @@
 #ifndef FORMAT_CST_HPP
 #define FORMAT_CST_HPP
 
+#include <array>
+#include <memory_resource>
+#include <span>
 #include <vector>
 #include <string_view>
 #include <algorithm>
 
 #include "unwrapped_line.hpp"
 #include "cst_visitor.hpp"
+#include "profile.hpp"
 
 using StringVector = std::vector<std::string>;
 
+// The classifiers accept any line type whose `tokens` member offers the
+// Tokens query API: UnwrappedLine, or a line over a TokenStore or a
+// line table.
 
 
-inline bool starts_with_keyword(const UnwrappedLine &line, std::string_view kw) {
-    return !line.tokens.empty() && line.tokens[0].kind == TokenKind::Keyword && line.tokens[0].text == kw;
+template<typename Line>
+inline bool starts_with_keyword(const Line &line, KeywordId kw) {
+    return !line.tokens.empty() && line.tokens[0].keyword == kw;
 }
 
-inline bool has_second_keyword(const UnwrappedLine &line, std::string_view kw) {
-    return line.tokens.size() > 1 && line.tokens[1].kind == TokenKind::Keyword && line.tokens[1].text == kw;
+template<typename Line>
+inline bool has_second_keyword(const Line &line, KeywordId kw) {
+    return line.tokens.size() > 1 && line.tokens[1].keyword == kw;
+}
+
+template<typename Line>
+inline bool starts_with_keyword(const Line &line, std::string_view kw) {
+    return starts_with_keyword(line, lookup_keyword(kw));
+}
+
+template<typename Line>
+inline bool has_second_keyword(const Line &line, std::string_view kw) {
+    return has_second_keyword(line, lookup_keyword(kw));
+}
+
+inline bool is_declaration_type_keyword(KeywordId kw) {
+    using KW = KeywordId;
+    return kw == KW::Integer || kw == KW::Real || kw == KW::Logical || kw == KW::Double;
 }
 
 inline bool is_declaration_type_keyword(std::string_view text) {
-    static constexpr std::string_view kinds[] = {"integer", "real", "logical", "double"};
-    return std::ranges::any_of(kinds, [&](std::string_view k) { return k == text; });
+    return is_declaration_type_keyword(lookup_keyword(text));
 }
 
-inline bool is_fortran_declaration(const UnwrappedLine &line) {
-    return !line.tokens.empty() && line.tokens[0].kind == TokenKind::Keyword && is_declaration_type_keyword(
-               line.tokens[0].text);
+template<typename Line>
+inline bool is_fortran_declaration(const Line &line) {
+    return !line.tokens.empty() && is_declaration_type_keyword(line.tokens[0].keyword);
 }
 
-inline bool is_assignment(const UnwrappedLine &line) {
+template<typename Line>
+inline bool is_assignment(const Line &line) {
     return line.tokens.contains_token("=");
 }
 
 
-inline bool is_type_construct(const UnwrappedLine &line) {
-    if (line.tokens.empty()) return false;
-    if (line.tokens.contains_token("type") && !line.tokens.contains_token_sequence<StringVector>({"type", "("})) {
-        return true;
+template<typename Line>
+inline bool is_type_construct(const Line &line) {
+    // "type" anywhere, but not the "type(" of a derived-type declaration
+    bool has_type = false;
+    for (std::size_t i = 0; i < line.tokens.size(); ++i) {
+        if (line.tokens[i].keyword != KeywordId::Type) continue;
+        if (i + 1 < line.tokens.size() && line.tokens[i + 1].kind == TokenKind::LParen) return false;
+        has_type = true;
     }
+    return has_type;
+}
+
+template<typename Line>
+inline bool is_module_procedure(const Line &line) {
+    // "module procedure" in any case; "procedure" is not a keyword
+    const auto is_procedure = [](std::string_view s) {
+        return std::ranges::equal(s, std::string_view("procedure"),
+                                  [](char a, char b) { return (a | 0x20) == b; });
+    };
+    const auto &tokens = line.tokens;
+    for (std::size_t i = 0; i + 1 < tokens.size(); ++i)
+        if (tokens[i].keyword == KeywordId::Module && is_procedure(tokens[i + 1].text)) return true;
     return false;
 }
 
-inline NodeKind classify_end_construct(const UnwrappedLine &line) {
+template<typename Line>
+inline NodeKind classify_end_construct(const Line &line) {
+    using KW = KeywordId;
+
     if (line.tokens.empty()) return NodeKind::Unknown;
 
     // Simple forms: endif, enddo
-    if (line.tokens.first_token_is("endif")) return NodeKind::EndIf;
-    if (line.tokens.first_token_is("enddo")) return NodeKind::EndDo;
-
-    // All multiword forms begin with "end"
-    if (!line.tokens.first_token_is("end")) return NodeKind::Unknown;
-
-    if (has_second_keyword(line, "program")) return NodeKind::EndProgram;
-    if (has_second_keyword(line, "module")) return NodeKind::EndModule;
-    if (has_second_keyword(line, "subroutine")) return NodeKind::EndSubroutine;
-    if (has_second_keyword(line, "function")) return NodeKind::EndFunction;
-    if (has_second_keyword(line, "interface")) return NodeKind::EndInterface;
-    if (has_second_keyword(line, "select")) return NodeKind::EndSelect;
-    if (has_second_keyword(line, "do")) return NodeKind::EndDo;
-    if (has_second_keyword(line, "if")) return NodeKind::EndIf;
-    if (has_second_keyword(line, "type")) return NodeKind::EndType;
+    switch (line.tokens[0].keyword) {
+        case KW::EndIf: return NodeKind::EndIf;
+        case KW::EndDo: return NodeKind::EndDo;
+        case KW::End: break;
+        // All multiword forms begin with "end"
+        default: return NodeKind::Unknown;
+    }
 
-    return NodeKind::Unknown;
+    if (line.tokens.size() < 2) return NodeKind::Unknown;
+
+    switch (line.tokens[1].keyword) {
+        case KW::Program: return NodeKind::EndProgram;
+        case KW::Module: return NodeKind::EndModule;
+        case KW::Subroutine: return NodeKind::EndSubroutine;
+        case KW::Function: return NodeKind::EndFunction;
+        case KW::Interface: return NodeKind::EndInterface;
+        case KW::Select: return NodeKind::EndSelect;
+        case KW::Do: return NodeKind::EndDo;
+        case KW::If: return NodeKind::EndIf;
+        case KW::Type: return NodeKind::EndType;
+        default: return NodeKind::Unknown;
+    }
 }
 
-inline NodeKind classify(const UnwrappedLine &line) {
+template<typename Line>
+inline NodeKind classify(const Line &line) {
     using K = TokenKind;
+    using KW = KeywordId;
 
     if (line.tokens.empty()) return NodeKind::Blank;
 
-    const Token &t0 = line.tokens.front();
+    const auto &t0 = line.tokens.front();
 
     // Comments
     if (t0.kind == K::Comment) return NodeKind::Comment;
 
     // END <construct>
-    if (starts_with_keyword(line, "end") || starts_with_keyword(line, "endif") || starts_with_keyword(line, "enddo")) {
+    if (t0.keyword == KW::End || t0.keyword == KW::EndIf || t0.keyword == KW::EndDo) {
         return classify_end_construct(line);
     }
 
     // module procedure special case
-    if (line.tokens.contains_token_sequence<StringVector>({"module", "procedure"})) return NodeKind::Declaration;
+    if (is_module_procedure(line)) return NodeKind::Declaration;
 
     // TYPE constructs
     if (is_type_construct(line)) return NodeKind::Type;
 
     // Keyword-driven constructs
     if (t0.kind == K::Keyword) {
-        // abstract interface
-        if (t0.text == "abstract" && has_second_keyword(line, "interface")) return NodeKind::Interface;
-
-        if (t0.text == "program") return NodeKind::Program;
-        if (t0.text == "module") return NodeKind::Module;
-        if (t0.text == "use") return NodeKind::Use;
-        if (t0.text == "call") return NodeKind::Call;
-        if (t0.text == "select") return NodeKind::SelectCase;
-        if (t0.text == "case") return NodeKind::Case;
-        if (t0.text == "interface") return NodeKind::Interface;
-        if (t0.text == "do") return NodeKind::Do;
-
-        if (t0.text == "print") return NodeKind::Call;
+        switch (t0.keyword) {
+            // abstract interface
+            case KW::Abstract:
+                if (has_second_keyword(line, KW::Interface)) return NodeKind::Interface;
+                break;
+            case KW::Program: return NodeKind::Program;
+            case KW::Module: return NodeKind::Module;
+            case KW::Use: return NodeKind::Use;
+            case KW::Call: return NodeKind::Call;
+            case KW::Select: return NodeKind::SelectCase;
+            case KW::Case: return NodeKind::Case;
+            case KW::Interface: return NodeKind::Interface;
+            case KW::Do: return NodeKind::Do;
+            case KW::Print: return NodeKind::Call;
+            default: break;
+        }
 
-        if (line.tokens.contains_token("function")) return NodeKind::Function;
+        if (line.tokens.contains_token(KW::Function)) return NodeKind::Function;
 
-        if (line.tokens.contains_token("subroutine")) return NodeKind::Subroutine;
+        if (line.tokens.contains_token(KW::Subroutine)) return NodeKind::Subroutine;
 
-        if (t0.text == "if") {
-            return line.tokens.contains_token("then") ? NodeKind::IfConstruct : NodeKind::If;
+        if (t0.keyword == KW::If) {
+            return line.tokens.contains_token(KW::Then) ? NodeKind::IfConstruct : NodeKind::If;
         }
 
-        if (t0.text == "else") {
-            if (line.tokens.size() > 1 && line.tokens[1].text == "if") return NodeKind::ElseIf;
+        if (t0.keyword == KW::Else) {
+            if (has_second_keyword(line, KW::If)) return NodeKind::ElseIf;
             return NodeKind::Else;
         }
     }
@@ -124,11 +178,13 @@ inline NodeKind classify(const UnwrappedLine &line) {
     return NodeKind::Unknown;
 }
 
-inline std::vector<CSTNode>
-build_cst(const std::vector<UnwrappedLine> &lines,
-          CSTVisitor* visitor = nullptr)
+template<typename Nodes>
+inline void build_cst_into(std::span<const UnwrappedLine> lines,
+                           Nodes &cst,
+                           CSTVisitor* visitor = nullptr)
 {
-    std::vector<CSTNode> cst;
+    FORMAT_PROFILE_SCOPE("build_cst", "nodes");
+    FORMAT_PROFILE_ITEMS(lines.size());
     cst.reserve(lines.size());
 
     auto last_real = NodeKind::Unknown;
@@ -136,6 +192,7 @@ build_cst(const std::vector<UnwrappedLine> &lines,
     for (const auto &line: lines) {
         CSTNode node;
         node.line = &line;
+        node.index = cst.size();
         node.kind = classify(line);
         node.prev_kind = last_real;
 
@@ -147,7 +204,75 @@ build_cst(const std::vector<UnwrappedLine> &lines,
 
         cst.push_back(node);
     }
+}
+
+inline std::vector<CSTNode>
+build_cst(std::span<const UnwrappedLine> lines,
+          CSTVisitor* visitor = nullptr)
+{
+    std::vector<CSTNode> cst;
+    build_cst_into(lines, cst, visitor);
+    return cst;
+}
+
+// Same, with the nodes allocated from `resource` (e.g. a FileArena).
+inline std::pmr::vector<CSTNode>
+build_cst(std::span<const UnwrappedLine> lines,
+          CSTVisitor* visitor,
+          std::pmr::memory_resource *resource)
+{
+    std::pmr::vector<CSTNode> cst(resource);
+    build_cst_into(lines, cst, visitor);
+    return cst;
+}
+
+// Same for index-range lines. Nodes carry no line pointer; node.index
+// selects the line in the table.
+template<typename Source, typename Nodes>
+inline void build_cst_into(const BasicLineTable<Source> &lines,
+                           Nodes &cst,
+                           CSTVisitor* visitor = nullptr)
+{
+    FORMAT_PROFILE_SCOPE("build_cst", "nodes");
+    FORMAT_PROFILE_ITEMS(lines.size());
+    cst.reserve(lines.size());
+
+    auto last_real = NodeKind::Unknown;
+
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        CSTNode node;
+        node.index = i;
+        node.kind = classify(lines[i]);
+        node.prev_kind = last_real;
+
+        if (node.kind != NodeKind::Blank &&
+            node.kind != NodeKind::Unknown)
+            last_real = node.kind;
+
+        if (visitor) visitor->on_node(node);
+
+        cst.push_back(node);
+    }
+}
+
+template<typename Source>
+inline std::vector<CSTNode>
+build_cst(const BasicLineTable<Source> &lines,
+          CSTVisitor* visitor = nullptr)
+{
+    std::vector<CSTNode> cst;
+    build_cst_into(lines, cst, visitor);
+    return cst;
+}
 
+template<typename Source>
+inline std::pmr::vector<CSTNode>
+build_cst(const BasicLineTable<Source> &lines,
+          CSTVisitor* visitor,
+          std::pmr::memory_resource *resource)
+{
+    std::pmr::vector<CSTNode> cst(resource);
+    build_cst_into(lines, cst, visitor);
     return cst;
 }
 
@@ -8,6 +8,7 @@ struct CSTNode {
     NodeKind kind = NodeKind::Unknown;
     NodeKind prev_kind = NodeKind::Unknown;
     const UnwrappedLine *line = nullptr;
+    std::size_t index = 0; // position of the line in its file
 };
 
 #endif //FORMAT_CST_NODE_HPP
\ No newline at end of file
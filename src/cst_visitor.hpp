@@ -4,6 +4,7 @@
 #include "cst_node.hpp"
 #include "kinds.hpp"
 #include <memory>
+#include <memory_resource>
 #include <vector>
 
 
@@ -12,20 +13,50 @@ struct CSTVisitor {
     virtual void on_enter(const CSTNode& node) {}
     virtual void on_exit(const CSTNode& node) {}
     virtual void on_node(const CSTNode& node) {}
+
+    // Visitors are called once per node, in line order, from one thread.
+    // A visitor that returns true here instead accepts on_node calls from
+    // several threads at once and in any order (see build_cst_parallel);
+    // each node is still visited exactly once, fully classified.
+    [[nodiscard]] virtual bool concurrent() const noexcept { return false; }
+};
+
+struct BlockNode;
+
+// Destroys a BlockNode and returns its memory to the resource it came
+// from; with a FileArena the memory itself is reclaimed on reset().
+struct BlockNodeDelete {
+    std::pmr::memory_resource *resource = std::pmr::get_default_resource();
+    void operator()(BlockNode *node) const noexcept;
 };
 
+using BlockNodePtr = std::unique_ptr<BlockNode, BlockNodeDelete>;
+
 struct BlockNode {
     std::shared_ptr<CSTNode> begin_node;
     std::shared_ptr<CSTNode> end_node;
     BlockNode* parent{nullptr};
-    std::vector<std::unique_ptr<BlockNode>> children{};
+    std::pmr::vector<BlockNodePtr> children{};
+
+    BlockNode() = default;
+    explicit BlockNode(std::pmr::memory_resource *resource) : children(resource) {}
 };
 
+inline void BlockNodeDelete::operator()(BlockNode *node) const noexcept {
+    std::pmr::polymorphic_allocator<BlockNode>(resource).delete_object(node);
+}
+
+// Keeps a copy of each begin/end node, line pointer included, so the
+// lines must outlive the tree. That rules out FusedPipeline, whose line
+// is reused after on_node; use FlatBlockTreeBuilder there.
 struct BlockTreeBuilder : public CSTVisitor {
-    std::unique_ptr<BlockNode> root = std::make_unique<BlockNode>();
+    BlockNodePtr root;
     BlockNode* current = nullptr;
 
-    BlockTreeBuilder() { current = root.get(); }
+    // Nodes are allocated from `resource`, e.g. a FileArena, which must
+    // outlive the builder.
+    explicit BlockTreeBuilder(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : root(make_block(resource)), m_resource(resource) { current = root.get(); }
 
     static bool begins_block(NodeKind k) {
         using NK = NodeKind;
@@ -51,11 +82,11 @@ struct BlockTreeBuilder : public CSTVisitor {
 
         if (begins_block(node.kind)) {
             if (!current->begin_node) {
-                current->begin_node = std::make_shared<CSTNode>(node);
+                current->begin_node = make_node(node);
             } else {
-                auto child = std::make_unique<BlockNode>();
+                auto child = make_block(m_resource);
                 child->parent = current;
-                child->begin_node = std::make_shared<CSTNode>(node);
+                child->begin_node = make_node(node);
                 auto num_children = current->children.size();
                 current->children.push_back(std::move(child));
                 current = current->children.back().get();
@@ -65,17 +96,29 @@ struct BlockTreeBuilder : public CSTVisitor {
 
         else if (ends_block(node.kind)) {
             if (!current->end_node) {
-                current->end_node = std::make_shared<CSTNode>(node);
+                current->end_node = make_node(node);
             } else {
                 // end of nested block; bubble back
                 if (current->parent) {
                     current = current->parent;
-                    current->end_node = std::make_shared<CSTNode>(node);
+                    current->end_node = make_node(node);
                 }
             }
             on_exit(node);
         }
     }
+
+private:
+    static BlockNodePtr make_block(std::pmr::memory_resource *resource) {
+        std::pmr::polymorphic_allocator<BlockNode> alloc(resource);
+        return BlockNodePtr(alloc.new_object<BlockNode>(resource), BlockNodeDelete{resource});
+    }
+
+    std::shared_ptr<CSTNode> make_node(const CSTNode &node) const {
+        return std::allocate_shared<CSTNode>(std::pmr::polymorphic_allocator<CSTNode>(m_resource), node);
+    }
+
+    std::pmr::memory_resource *m_resource;
 };
 
 
@@ -0,0 +1,173 @@
+#include "format_cache.hpp"
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <thread>
+
+// ============================================================
+// Content Hash
+// ============================================================
+
+namespace {
+    constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+    constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+    constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+    constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+    uint64_t read64(const char *p) noexcept {
+        uint64_t v;
+        std::memcpy(&v, p, 8);
+        return std::endian::native == std::endian::little ? v : std::byteswap(v);
+    }
+
+    uint32_t read32(const char *p) noexcept {
+        uint32_t v;
+        std::memcpy(&v, p, 4);
+        return std::endian::native == std::endian::little ? v : std::byteswap(v);
+    }
+
+    uint64_t round(uint64_t acc, uint64_t input) noexcept {
+        return std::rotl(acc + input * P2, 31) * P1;
+    }
+
+    uint64_t merge(uint64_t acc, uint64_t v) noexcept {
+        return (acc ^ round(0, v)) * P1 + P4;
+    }
+}
+
+uint64_t hash64(std::string_view data, uint64_t seed) noexcept {
+    const char *p = data.data();
+    const char *const end = p + data.size();
+    uint64_t h;
+
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + P1 + P2, v2 = seed + P2, v3 = seed, v4 = seed - P1;
+        for (; end - p >= 32; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        h = merge(merge(merge(merge(h, v1), v2), v3), v4);
+    } else {
+        h = seed + P5;
+    }
+
+    h += data.size();
+
+    for (; end - p >= 8; p += 8) h = std::rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+    if (end - p >= 4) {
+        h = std::rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; ++p) h = std::rotl(h ^ (static_cast<unsigned char>(*p) * P5), 11) * P1;
+
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// ============================================================
+// Format Cache
+// ============================================================
+
+namespace {
+    constexpr char unchanged_marker = '=';
+    constexpr char changed_marker = '+';
+
+    // Distinct per process and per call, for temporary file names.
+    uint64_t unique_token() {
+        static const uint64_t process = std::random_device{}() ^ (uint64_t{std::random_device{}()} << 32);
+        static std::atomic<uint64_t> counter{0};
+        const auto thread = std::hash<std::thread::id>{}(std::this_thread::get_id());
+        return process ^ hash64({reinterpret_cast<const char *>(&thread), sizeof thread}, ++counter);
+    }
+
+    std::string hex(uint64_t v) {
+        std::array<char, 17> buf;
+        std::snprintf(buf.data(), buf.size(), "%016llx", static_cast<unsigned long long>(v));
+        return buf.data();
+    }
+}
+
+FormatCache::FormatCache(std::filesystem::path directory, const FormatOptions &options)
+    : m_directory(std::move(directory)), m_seed(seed(options)) {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+}
+
+uint64_t FormatCache::seed(const FormatOptions &options) noexcept {
+    const std::array<int64_t, 5> fields{
+        FortranFormatter::version,
+        options.indent_width,
+        options.continuation_indent,
+        static_cast<int64_t>(options.keyword_case),
+        options.max_blank_lines,
+    };
+    return hash64({reinterpret_cast<const char *>(fields.data()), sizeof fields});
+}
+
+// <dir>/<first two hex digits>/<rest>-<size>, fanned out like git objects.
+std::filesystem::path FormatCache::entry(std::string_view source) const {
+    const std::string key = hex(hash64(source, m_seed));
+    return m_directory / key.substr(0, 2) / (key.substr(2) + '-' + std::to_string(source.size()));
+}
+
+std::optional<CachedResult> FormatCache::lookup(std::string_view source) const {
+    std::ifstream in(entry(source), std::ios::binary);
+    if (!in) return std::nullopt;
+
+    std::string data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+    if (in.bad() || data.empty()) return std::nullopt;
+
+    if (data.front() == unchanged_marker && data.size() == 1) return CachedResult{};
+    if (data.front() == changed_marker) {
+        data.erase(0, 1);
+        return CachedResult{true, std::move(data)};
+    }
+    return std::nullopt;
+}
+
+void FormatCache::store(std::string_view source, std::string_view output) const noexcept {
+    try {
+        const auto path = entry(source);
+        std::error_code ec;
+        std::filesystem::create_directories(path.parent_path(), ec);
+        if (ec) return;
+
+        auto temp = path;
+        temp += ".tmp" + hex(unique_token());
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            if (output == source) {
+                out.put(unchanged_marker);
+            } else {
+                out.put(changed_marker);
+                out.write(output.data(), static_cast<std::streamsize>(output.size()));
+            }
+            out.close();
+            if (!out) {
+                std::filesystem::remove(temp, ec);
+                return;
+            }
+        }
+
+        // Atomic replace: readers see the old entry or the new one, and
+        // racing writers all write the same bytes.
+        std::filesystem::rename(temp, path, ec);
+        if (ec) std::filesystem::remove(temp, ec);
+    } catch (...) {
+        // a failed store is only a future miss
+    }
+}
@@ -0,0 +1,58 @@
+#ifndef FORMAT_FORMAT_CACHE_HPP
+#define FORMAT_FORMAT_CACHE_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "formatter.hpp"
+
+// ============================================================
+// Content Hash
+// ============================================================
+
+// XXH64 of `data`.
+uint64_t hash64(std::string_view data, uint64_t seed = 0) noexcept;
+
+// ============================================================
+// Format Cache
+// ============================================================
+//
+// Remembers, on disk, what formatting produced for a given input, so an
+// unchanged file skips the pipeline entirely. Entries are keyed by a
+// hash of the file's contents seeded with the formatter version and the
+// options, so changing either simply misses. A file that was already
+// formatted is stored as a one-byte marker rather than a second copy.
+//
+// Entries are written to a private temporary file and renamed into
+// place, so concurrent writers, even in different processes, never
+// expose a partial entry; the cache is best effort and never throws.
+
+struct CachedResult {
+    bool changed = false; // false: the input was already formatted
+    std::string output;   // formatted text when changed, empty otherwise
+};
+
+class FormatCache {
+public:
+    explicit FormatCache(std::filesystem::path directory, const FormatOptions &options = {});
+
+    [[nodiscard]] std::optional<CachedResult> lookup(std::string_view source) const;
+
+    void store(std::string_view source, std::string_view output) const noexcept;
+
+    [[nodiscard]] const std::filesystem::path &directory() const noexcept { return m_directory; }
+
+    // Seed for the content hash: the formatter version and every option.
+    static uint64_t seed(const FormatOptions &options) noexcept;
+
+private:
+    [[nodiscard]] std::filesystem::path entry(std::string_view source) const;
+
+    std::filesystem::path m_directory;
+    uint64_t m_seed;
+};
+
+#endif // FORMAT_FORMAT_CACHE_HPP
@@ -0,0 +1,334 @@
+#ifndef FORMAT_FORMATTER_HPP
+#define FORMAT_FORMATTER_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "arena.hpp"
+#include "cst.hpp"
+#include "cst_visitor.hpp"
+#include "profile.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+
+// ============================================================
+// Output Writer
+// ============================================================
+//
+// Single-pass writer into one buffer that is sized up front from the
+// input; lines are written token by token, never built as strings.
+// The buffer only grows (by doubling) if the estimate was too small.
+
+class OutputWriter {
+public:
+    explicit OutputWriter(std::size_t capacity = 0) {
+        m_data.resize(capacity);
+    }
+
+    void put(char c) {
+        ensure(1);
+        m_data[m_size++] = c;
+    }
+
+    void put(std::string_view text) {
+        ensure(text.size());
+        std::memcpy(m_data.data() + m_size, text.data(), text.size());
+        m_size += text.size();
+    }
+
+    void put_spaces(std::size_t n) {
+        ensure(n);
+        std::memset(m_data.data() + m_size, ' ', n);
+        m_size += n;
+    }
+
+    // Writes text with every character passed through f.
+    template<typename F>
+    void put_transformed(std::string_view text, F f) {
+        ensure(text.size());
+        char *out = m_data.data() + m_size;
+        for (char c : text) *out++ = f(c);
+        m_size += text.size();
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept { return m_size; }
+    [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+    [[nodiscard]] std::string_view view() const noexcept { return {m_data.data(), m_size}; }
+
+    // Empties the writer and keeps its buffer, for writing line by line.
+    void clear() noexcept { m_size = 0; }
+
+    // Hands over the written text; the writer is empty afterwards.
+    [[nodiscard]] std::string take() {
+        m_data.resize(m_size);
+        m_size = 0;
+        return std::move(m_data);
+    }
+
+private:
+    void ensure(std::size_t n) {
+        if (m_size + n > m_data.size())
+            m_data.resize(std::max(m_data.size() * 2, m_size + n));
+    }
+
+    std::string m_data;
+    std::size_t m_size = 0;
+};
+
+// ============================================================
+// Format Options
+// ============================================================
+
+enum class KeywordCase { Preserve, Lower, Upper };
+
+struct FormatOptions {
+    int indent_width = 2;
+    int continuation_indent = 4; // relative to the statement's indent
+    KeywordCase keyword_case = KeywordCase::Lower;
+    int max_blank_lines = 1;
+};
+
+// Carried from line to line; lets a caller format a stretch of lines
+// as if the lines before it had been formatted too.
+struct FormatState {
+    int depth = 0;      // open blocks
+    int blank_run = 0;  // blank lines just written
+};
+
+// ============================================================
+// Fortran Formatter
+// ============================================================
+//
+// Reindents each logical line by block depth and normalizes the spacing
+// between its tokens:
+//
+//   - runs of blanks collapse to one space, trailing blanks go away,
+//     also at the end of a comment;
+//   - one space after ',' and ';' and none before them, none inside
+//     parentheses, none around '%' or an array-section ':';
+//   - one space around '==', '/=', '<', '>', '<=', '>=', '=>', '::' and
+//     an '=' outside parentheses (keyword arguments stay as written),
+//     and before a trailing comment or continuation '&';
+//   - "if(" and "case(" get a space;
+//   - keywords are recased.
+//
+// Tokens that were written together in the source stay together unless
+// a rule above separates them, so spellings the lexer splits (".and.",
+// "1.0_dp") survive. Continuation lines are re-emitted one per '&'.
+// Preprocessor lines are copied verbatim.
+
+class FortranFormatter {
+public:
+    // Bumped whenever some input formats differently than before.
+    static constexpr int version = 1;
+
+    explicit FortranFormatter(FormatOptions options = {}) : m_options(options) {}
+
+    [[nodiscard]] const FormatOptions &options() const noexcept { return m_options; }
+
+    [[nodiscard]] std::string format(std::string_view source) const {
+        FortranTokenizer tz(source);
+        const auto tokens = tz.tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse_ranges();
+        const auto cst = build_cst(lines);
+
+        OutputWriter out(estimate(source.size()));
+        FormatState state;
+        emit(source, lines, cst, out, state);
+        return out.take();
+    }
+
+    // Same, with the tokens, lines and nodes allocated from `arena`, which
+    // is reset first. Only the returned text outlives the call.
+    [[nodiscard]] std::string format(std::string_view source, FileArena &arena) const {
+        arena.reset(FileArena::estimate(source.size()));
+
+        FortranTokenizer tz(source);
+        const auto tokens = tz.tokenize(arena.resource());
+        const auto lines = UnwrappedLineParser(tokens).parse_ranges(arena.resource());
+        const auto cst = build_cst(lines, nullptr, arena.resource());
+
+        OutputWriter out(estimate(source.size()));
+        FormatState state;
+        emit(source, lines, cst, out, state);
+        return out.take();
+    }
+
+    static constexpr std::size_t estimate(std::size_t source_size) noexcept {
+        return source_size + source_size / 4 + 64;
+    }
+
+    // Writes the lines of `cst` (nodes index into `lines`: a LineTable or
+    // a vector of UnwrappedLine).
+    template<typename Lines>
+    void emit(std::string_view source, const Lines &lines, std::span<const CSTNode> cst,
+              OutputWriter &out, FormatState &state) const {
+        FORMAT_PROFILE_SCOPE("emit", "lines");
+        FORMAT_PROFILE_ITEMS(cst.size());
+        for (const auto &node : cst)
+            emit_line(source, lines[node.index].tokens, node.kind, out, state);
+    }
+
+    // Indentation depth of a line of this kind, given the open blocks
+    // before it; advances `depth` past the line.
+    static int line_depth(NodeKind kind, KeywordId first, int &depth) noexcept {
+        if (BlockTreeBuilder::ends_block(kind)) {
+            depth = std::max(0, depth - 1);
+            return depth;
+        }
+        if (BlockTreeBuilder::begins_block(kind))
+            return depth++;
+
+        // Branches of a construct sit at the construct's own level.
+        const bool dedent = kind == NodeKind::Else || kind == NodeKind::ElseIf ||
+                            kind == NodeKind::Case || first == KeywordId::Contains;
+        return dedent ? std::max(0, depth - 1) : depth;
+    }
+
+    template<typename LineTokens>
+    void emit_line(std::string_view source, const LineTokens &tokens, NodeKind kind,
+                   OutputWriter &out, FormatState &state) const {
+        const std::size_t n = tokens.size();
+
+        // the empty line after the last newline, or the EndOfFile that is
+        // all an empty source has
+        if (n == 0 || tokens.front().kind == TokenKind::EndOfFile) return;
+
+        if (tokens.front().kind == TokenKind::Newline) {
+            if (++state.blank_run <= m_options.max_blank_lines) out.put('\n');
+            return;
+        }
+        state.blank_run = 0;
+
+        const int depth = line_depth(kind, tokens.front().keyword, state.depth);
+
+        if (tokens.front().kind == TokenKind::Unknown && tokens.front().text == "#") {
+            emit_verbatim(source, tokens, out);
+            return;
+        }
+
+        const std::size_t indent = static_cast<std::size_t>(depth * m_options.indent_width);
+        out.put_spaces(indent);
+
+        const Token *prev = nullptr;
+        bool prev_fused = false; // prev is the second half of "::" or "=>"
+        int parens = 0;
+
+        for (std::size_t i = 0; i < n; ++i) {
+            const Token &cur = tokens[i];
+            if (cur.kind == TokenKind::Newline) break;
+
+            const Token *next = i + 1 < n ? &tokens[i + 1] : nullptr;
+            const bool fused = prev && fuses(*prev, cur);
+
+            if (prev && space_between(*prev, cur, next, fused, prev_fused, parens > 0))
+                out.put(' ');
+
+            put_token(cur, out);
+            if (cur.kind == TokenKind::LParen) ++parens;
+            if (cur.kind == TokenKind::RParen && parens > 0) --parens;
+
+            // A trailing '&': the statement continues on the next line.
+            if (cur.kind == TokenKind::Continuation && next &&
+                next->kind != TokenKind::Newline && next->line != cur.line) {
+                out.put('\n');
+                out.put_spaces(indent + static_cast<std::size_t>(m_options.continuation_indent));
+                prev = nullptr;
+                prev_fused = false;
+                continue;
+            }
+
+            prev = &cur;
+            prev_fused = fused;
+        }
+
+        out.put('\n');
+    }
+
+private:
+    // Relational operators, and '=' outside parentheses (an assignment or
+    // a loop bound rather than a keyword argument).
+    static bool is_spaced_operator(const Token &t, bool in_parens) noexcept {
+        if (t.kind != TokenKind::Operator) return false;
+        const auto s = t.text;
+        if (s == "=") return !in_parens;
+        return s == "==" || s == "/=" || s == "<" || s == ">" || s == "<=" || s == ">=";
+    }
+
+    // Written together in the source, with nothing in between.
+    static bool adjacent(const Token &a, const Token &b) noexcept {
+        return a.line == b.line && a.text.data() + a.text.size() == b.text.data();
+    }
+
+    // Two tokens the lexer splits but that form one symbol: "::" and "=>".
+    static bool fuses(const Token &a, const Token &b) noexcept {
+        if (!adjacent(a, b)) return false;
+        if (a.kind == TokenKind::Colon && b.kind == TokenKind::Colon) return true;
+        return a.kind == TokenKind::Operator && a.text == "=" &&
+               b.kind == TokenKind::Operator && b.text == ">";
+    }
+
+    static bool space_between(const Token &prev, const Token &cur, const Token *next,
+                              bool fused, bool prev_fused, bool in_parens) noexcept {
+        using K = TokenKind;
+
+        if (fused) return false;
+        if (prev_fused) return true;
+        if (next && fuses(cur, *next)) return true;
+
+        if (cur.kind == K::Comment || cur.kind == K::Continuation) return true;
+        if (prev.kind == K::Continuation) return !adjacent(prev, cur);
+
+        if (cur.kind == K::Comma || cur.kind == K::Semicolon || cur.kind == K::RParen) return false;
+        if (prev.kind == K::Comma || prev.kind == K::Semicolon) return true;
+        if (prev.kind == K::LParen) return false;
+
+        if (prev.kind == K::Percent || cur.kind == K::Percent) return false;
+
+        // array sections are tight; "only: x" is not
+        if (cur.kind == K::Colon) return false;
+        if (prev.kind == K::Colon) return !in_parens;
+
+        if (is_spaced_operator(prev, in_parens) || is_spaced_operator(cur, in_parens)) return true;
+
+        if (cur.kind == K::LParen &&
+            (prev.keyword == KeywordId::If || prev.keyword == KeywordId::Case))
+            return true;
+
+        return !adjacent(prev, cur);
+    }
+
+    void put_token(const Token &t, OutputWriter &out) const {
+        if (t.kind == TokenKind::Comment) {
+            const auto end = t.text.find_last_not_of(" \t");
+            out.put(t.text.substr(0, end == std::string_view::npos ? 0 : end + 1));
+        } else if (t.kind != TokenKind::Keyword || m_options.keyword_case == KeywordCase::Preserve) {
+            out.put(t.text);
+        } else if (m_options.keyword_case == KeywordCase::Lower) {
+            out.put_transformed(t.text, [](char c) { return static_cast<char>(c | (c >= 'A' && c <= 'Z' ? 0x20 : 0)); });
+        } else {
+            out.put_transformed(t.text, [](char c) { return static_cast<char>(c >= 'a' && c <= 'z' ? c - 0x20 : c); });
+        }
+    }
+
+    template<typename LineTokens>
+    static void emit_verbatim(std::string_view source, const LineTokens &tokens, OutputWriter &out) {
+        const char *begin = tokens.front().text.data();
+        const char *end = begin;
+        for (const Token &t : tokens) {
+            if (t.kind == TokenKind::Newline) break;
+            const char *b = t.text.data();
+            if (b < source.data() || b + t.text.size() > source.data() + source.size()) continue;
+            end = std::max(end, b + t.text.size());
+        }
+        out.put(std::string_view(begin, static_cast<std::size_t>(end - begin)));
+        out.put('\n');
+    }
+
+    FormatOptions m_options;
+};
+
+#endif // FORMAT_FORMATTER_HPP
@@ -0,0 +1,183 @@
+#ifndef FORMAT_FUSED_PIPELINE_HPP
+#define FORMAT_FUSED_PIPELINE_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+#include "cst.hpp"
+#include "cst_visitor.hpp"
+#include "profile.hpp"
+#include "split_scanner.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+
+// ============================================================
+// Fused Line Pipeline
+// ============================================================
+//
+// Tokenize, unwrap and classify in one pass. Tokens go straight from the
+// lexer into the current logical line; as soon as the line is complete
+// it is classified and handed to the visitor, then its storage is reused
+// for the next one:
+//
+//     FusedPipeline pipeline(visitor);
+//     pipeline.run(source);
+//
+// or, over chunked input,
+//
+//     while (read(chunk)) pipeline.feed(chunk);
+//     pipeline.finish();
+//
+// The visitor sees the nodes build_cst would produce, in the same order.
+// node.line points at the pipeline's current line and is valid only for
+// the duration of on_node, so visitors that keep nodes (BlockTreeBuilder)
+// must not be used here; FlatBlockTreeBuilder keeps indices only.
+//
+// Memory is bounded by the longest logical line (plus, with feed(), the
+// chunk size); no token, line or node arrays are built.
+
+class FusedPipeline {
+public:
+    explicit FusedPipeline(CSTVisitor &visitor, SymbolTable *symbols = nullptr)
+        : m_visitor(visitor), m_symbols(symbols) {}
+
+    // The whole source at once. Nothing is copied.
+    void run(std::string_view source) {
+        FORMAT_PROFILE_SCOPE("fused", "lines");
+        FortranTokenizer tz(source, m_symbols);
+        Sink sink{*this, true};
+        tz.tokenize_into(sink);
+        FORMAT_PROFILE_ITEMS(m_lines);
+    }
+
+    // Input may be cut anywhere; complete logical lines are processed as
+    // soon as they are in.
+    void feed(std::string_view chunk) {
+        const std::size_t scanned = m_buffer.size();
+        m_buffer.append(chunk);
+
+        if (std::size_t cut = m_scanner.scan(std::string_view(m_buffer).substr(scanned))) {
+            process(scanned + cut, false);
+            m_buffer.erase(0, scanned + cut);
+        }
+    }
+
+    // No more input will follow.
+    void finish() {
+        process(m_buffer.size(), true);
+        m_buffer.clear();
+    }
+
+    // Logical lines (nodes) visited so far.
+    [[nodiscard]] std::size_t lines() const noexcept { return m_lines; }
+
+    // Most tokens held at once: the size of the window.
+    [[nodiscard]] std::size_t max_line_tokens() const noexcept { return m_max_line_tokens; }
+
+private:
+    // The tokenizer's output container: unwraps lines as the tokens
+    // arrive, as UnwrappedLineParser::parse does.
+    struct Sink {
+        FusedPipeline &pipeline;
+        bool last; // whether this piece's EndOfFile ends the input
+
+        void push_back(const Token &t) { pipeline.take(t, last); }
+    };
+
+    void process(std::size_t end, bool last) {
+        FORMAT_PROFILE_SCOPE("fused", "lines");
+        [[maybe_unused]] const std::size_t before = m_lines;
+        FortranTokenizer tz(std::string_view(m_buffer).substr(0, end), m_next_line, m_symbols);
+        Sink sink{*this, last};
+        tz.tokenize_into(sink);
+        FORMAT_PROFILE_ITEMS(m_lines - before);
+    }
+
+    void take(const Token &t, bool last) {
+        if (t.kind == TokenKind::EndOfFile) {
+            if (!last) {
+                // The piece's EndOfFile sits where the next piece starts.
+                m_next_line = t.line;
+                return;
+            }
+            if (m_held) unwrap(m_continuation, t.kind);
+            m_held = false;
+            // An input without tokens is one line holding the EndOfFile.
+            if (!m_seen_tokens) m_line.tokens.push_back(t);
+            end_line();
+            return;
+        }
+
+        m_seen_tokens = true;
+
+        // A '&' ends the line only if a Newline follows, so it waits for
+        // the next token. It never ends a piece: the Newline after it is
+        // not a split point.
+        if (m_held) {
+            m_held = false;
+            unwrap(m_continuation, t.kind);
+        }
+        if (t.kind == TokenKind::Continuation) {
+            m_continuation = t;
+            m_held = true;
+            return;
+        }
+        unwrap(t, TokenKind::Unknown);
+    }
+
+    void unwrap(const Token &cur, TokenKind next) {
+        if (m_skip_next_newline) {
+            if (cur.kind == TokenKind::Newline) {
+                m_skip_next_newline = false;
+                return;
+            }
+        }
+
+        if (cur.kind == TokenKind::Continuation && next == TokenKind::Newline) {
+            m_line.tokens.push_back(cur);
+            m_skip_next_newline = true;
+            return;
+        }
+        if (cur.kind != TokenKind::Whitespace) m_line.tokens.push_back(cur);
+
+        if (cur.kind == TokenKind::Newline) end_line();
+    }
+
+    void end_line() {
+        m_max_line_tokens = std::max(m_max_line_tokens, m_line.tokens.size());
+
+        CSTNode node;
+        node.line = &m_line;
+        node.index = m_lines++;
+        node.kind = classify(m_line);
+        node.prev_kind = m_last_real;
+
+        if (node.kind != NodeKind::Blank &&
+            node.kind != NodeKind::Unknown)
+            m_last_real = node.kind;
+
+        m_visitor.on_node(node);
+        m_line.tokens.clear();
+    }
+
+    CSTVisitor &m_visitor;
+    SymbolTable *m_symbols;
+
+    UnwrappedLine m_line;
+    Token m_continuation{};
+    bool m_held = false; // m_continuation waits for the next token
+    bool m_skip_next_newline = false;
+    bool m_seen_tokens = false;
+    NodeKind m_last_real = NodeKind::Unknown;
+    std::size_t m_lines = 0;
+    std::size_t m_max_line_tokens = 0;
+
+    // feed() only
+    SplitScanner m_scanner;
+    std::string m_buffer;
+    int m_next_line = 1;
+};
+
+#endif // FORMAT_FUSED_PIPELINE_HPP
@@ -0,0 +1,294 @@
+#include "incremental.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "cst.hpp"
+#include "split_scanner.hpp"
+#include "tokenizer.hpp"
+
+namespace {
+    bool is_real(NodeKind k) noexcept {
+        return k != NodeKind::Blank && k != NodeKind::Unknown;
+    }
+
+    bool is_block_event(NodeKind k) noexcept {
+        return BlockTreeBuilder::begins_block(k) || BlockTreeBuilder::ends_block(k);
+    }
+
+    // Cuts text into pieces at safe split points, one physical line at a
+    // time, so that text can be appended while scanning continues.
+    class LineSplitter {
+    public:
+        void append(std::string_view more) { m_text.append(more); }
+
+        // Moves every piece completed so far into `pieces`.
+        void scan(std::vector<std::string> &pieces) {
+            for (std::size_t nl; (nl = m_text.find('\n', m_scanned)) != std::string::npos;) {
+                const std::size_t length = nl + 1 - m_scanned;
+                const bool cut = m_scanner.scan(std::string_view(m_text).substr(m_scanned, length)) == length;
+                m_scanned = nl + 1;
+                if (cut) {
+                    pieces.push_back(m_text.substr(m_start, m_scanned - m_start));
+                    m_start = m_scanned;
+                }
+            }
+        }
+
+        // Everything appended so far ends in a split point.
+        [[nodiscard]] bool at_cut() const noexcept { return m_start == m_text.size(); }
+
+        [[nodiscard]] std::string rest() const { return m_text.substr(m_start); }
+
+    private:
+        SplitScanner m_scanner;
+        std::string m_text;
+        std::size_t m_scanned = 0;
+        std::size_t m_start = 0;
+    };
+}
+
+// ============================================================
+// Pieces
+// ============================================================
+
+std::unique_ptr<IncrementalDocument::Piece>
+IncrementalDocument::make_piece(std::string text, bool first, bool only) {
+    auto piece = std::make_unique<Piece>();
+    piece->text = std::move(text);
+
+    // Pieces after the first resume after the previous piece's Newline.
+    const int base = first ? 1 : 2;
+    FortranTokenizer tz(std::string_view(piece->text), base);
+    const auto tokens = tz.tokenize();
+    piece->lines = tokens.back().line - base;
+
+    // The empty piece after the final newline is an empty line, unless
+    // it is the whole text (see UnwrappedLineParser::parse).
+    if (!piece->text.empty() || only)
+        piece->line = UnwrappedLineParser(tokens).parse().front();
+
+    return piece;
+}
+
+IncrementalDocument::IncrementalDocument(std::string_view text) {
+    LineSplitter splitter;
+    splitter.append(text);
+    std::vector<std::string> texts;
+    splitter.scan(texts);
+    texts.push_back(splitter.rest());
+
+    m_pieces.reserve(texts.size());
+    m_offsets.reserve(texts.size());
+    m_cst.reserve(texts.size());
+
+    auto last = NodeKind::Unknown;
+    for (std::size_t i = 0; i < texts.size(); ++i) {
+        m_offsets.push_back(m_size);
+        m_size += texts[i].size();
+        m_pieces.push_back(make_piece(std::move(texts[i]), i == 0, texts.size() == 1));
+
+        CSTNode node;
+        node.line = &m_pieces.back()->line;
+        node.index = i;
+        node.kind = classify(*node.line);
+        node.prev_kind = last;
+        if (is_real(node.kind)) last = node.kind;
+        m_cst.push_back(node);
+    }
+
+    m_blocks = FlatBlockTreeBuilder::build(m_cst);
+}
+
+// ============================================================
+// Edits
+// ============================================================
+
+EditResult IncrementalDocument::apply(const TextEdit &edit) {
+    if (edit.offset > m_size || edit.length > m_size - edit.offset)
+        throw std::out_of_range("IncrementalDocument::apply: edit outside the text");
+
+    const std::size_t s0 = line_at(edit.offset);
+    const std::size_t end = edit.offset + edit.length;
+    std::size_t s1 = (edit.length == 0 ? s0 : line_at(end - 1)) + 1;
+
+    // New text of the touched pieces, extended piece by piece until it
+    // ends in a split point that was also an old piece boundary.
+    LineSplitter splitter;
+    splitter.append(std::string_view(m_pieces[s0]->text).substr(0, edit.offset - m_offsets[s0]));
+    splitter.append(edit.replacement);
+    splitter.append(std::string_view(m_pieces[s1 - 1]->text).substr(end - m_offsets[s1 - 1]));
+
+    std::vector<std::string> texts;
+    splitter.scan(texts);
+
+    while (true) {
+        // The first piece is tokenized differently, so a piece that
+        // becomes first is always rebuilt.
+        const bool first_kept = s0 == 0 && texts.empty();
+        if (splitter.at_cut() && s1 < m_pieces.size() && !first_kept) break;
+        if (s1 == m_pieces.size()) {
+            texts.push_back(splitter.rest());
+            break;
+        }
+        splitter.append(m_pieces[s1++]->text);
+        splitter.scan(texts);
+    }
+
+    const std::size_t removed = s1 - s0;
+    const std::size_t inserted = texts.size();
+    const std::size_t new_size = m_pieces.size() - removed + inserted;
+
+    // Block events of the old lines, to decide whether the tree keeps its shape.
+    std::vector<std::pair<uint32_t, bool>> old_events;
+    for (std::size_t i = s0; i < s1; ++i)
+        if (is_block_event(m_cst[i].kind))
+            old_events.emplace_back(static_cast<uint32_t>(i), BlockTreeBuilder::begins_block(m_cst[i].kind));
+
+    // Pieces and offsets.
+    std::vector<std::unique_ptr<Piece>> fresh;
+    std::vector<std::size_t> fresh_offsets;
+    std::size_t offset = m_offsets[s0];
+    for (std::size_t k = 0; k < inserted; ++k) {
+        fresh_offsets.push_back(offset);
+        offset += texts[k].size();
+        fresh.push_back(make_piece(std::move(texts[k]), s0 + k == 0, new_size == 1));
+    }
+
+    const auto delta_bytes = static_cast<std::ptrdiff_t>(edit.replacement.size()) -
+                             static_cast<std::ptrdiff_t>(edit.length);
+
+    m_pieces.erase(m_pieces.begin() + s0, m_pieces.begin() + s1);
+    m_pieces.insert(m_pieces.begin() + s0, std::make_move_iterator(fresh.begin()),
+                    std::make_move_iterator(fresh.end()));
+
+    m_offsets.erase(m_offsets.begin() + s0, m_offsets.begin() + s1);
+    m_offsets.insert(m_offsets.begin() + s0, fresh_offsets.begin(), fresh_offsets.end());
+    for (std::size_t i = s0 + inserted; i < m_offsets.size(); ++i)
+        m_offsets[i] += delta_bytes;
+    m_size += delta_bytes;
+
+    // Nodes: classify the new lines, then repair prev_kind up to the
+    // first real node after them.
+    auto last = NodeKind::Unknown;
+    if (s0 > 0) last = is_real(m_cst[s0 - 1].kind) ? m_cst[s0 - 1].kind : m_cst[s0 - 1].prev_kind;
+
+    std::vector<CSTNode> nodes(inserted);
+    for (std::size_t k = 0; k < inserted; ++k) {
+        CSTNode &node = nodes[k];
+        node.line = &m_pieces[s0 + k]->line;
+        node.kind = classify(*node.line);
+        node.prev_kind = last;
+        if (is_real(node.kind)) last = node.kind;
+    }
+
+    m_cst.erase(m_cst.begin() + s0, m_cst.begin() + s1);
+    m_cst.insert(m_cst.begin() + s0, nodes.begin(), nodes.end());
+
+    if (inserted != removed) {
+        for (std::size_t i = s0; i < m_cst.size(); ++i) m_cst[i].index = i;
+    } else {
+        for (std::size_t i = s0; i < s0 + inserted; ++i) m_cst[i].index = i;
+    }
+
+    for (std::size_t i = s0 + inserted; i < m_cst.size(); ++i) {
+        m_cst[i].prev_kind = last;
+        if (is_real(m_cst[i].kind)) break;
+    }
+
+    // Block events of the new lines.
+    std::vector<std::pair<uint32_t, bool>> new_events;
+    for (std::size_t i = s0; i < s0 + inserted; ++i)
+        if (is_block_event(m_cst[i].kind))
+            new_events.emplace_back(static_cast<uint32_t>(i), BlockTreeBuilder::begins_block(m_cst[i].kind));
+
+    const bool same_shape = std::ranges::equal(old_events, new_events, {},
+        [](const auto &e) { return e.second; }, [](const auto &e) { return e.second; });
+
+    // Block tree. Blocks are numbered in the order they begin, so the
+    // ones that begin at or after the edit are a suffix of the ids, and
+    // the ones still open there are the ancestors of the block before it.
+    // Only these hold node indices that move.
+    const auto begins = m_blocks.begins();
+    const auto tail = static_cast<uint32_t>(
+        std::lower_bound(begins.begin() + 1, begins.end(), static_cast<uint32_t>(s0)) - begins.begin());
+
+    // The innermost block around all of the edited lines.
+    uint32_t enclosing = FlatBlockTree::root;
+    for (uint32_t b = tail - 1; b != FlatBlockTree::root; b = m_blocks.parent(b)) {
+        if (m_blocks.end(b) != FlatBlockTree::none && m_blocks.end(b) >= s1) {
+            enclosing = b;
+            break;
+        }
+    }
+
+    // If the edited lines open and close blocks in the same pattern as
+    // before, only the node indices move.
+    const auto delta_nodes = static_cast<int64_t>(inserted) - static_cast<int64_t>(removed);
+    const auto remap = [&](uint32_t x) -> uint32_t {
+        if (x == FlatBlockTree::none || x < s0) return x;
+        if (x >= s1) return static_cast<uint32_t>(x + delta_nodes);
+        if (!same_shape) return x; // inside the enclosing block, rebuilt below
+        const auto it = std::ranges::lower_bound(old_events, x, {}, [](const auto &e) { return e.first; });
+        return new_events[static_cast<std::size_t>(it - old_events.begin())].first;
+    };
+    for (uint32_t b = tail - 1; b != FlatBlockTree::root; b = m_blocks.parent(b))
+        m_blocks.set_end(b, remap(m_blocks.end(b)));
+    for (auto b = tail; b < m_blocks.size(); ++b) {
+        m_blocks.set_begin(b, remap(m_blocks.begin(b)));
+        m_blocks.set_end(b, remap(m_blocks.end(b)));
+    }
+
+    // Otherwise the enclosing block's contents are rebuilt, as long as
+    // they still close every block they open; if not, the pairing of
+    // every later end line may change and the whole tree is rebuilt.
+    if (!same_shape && enclosing != FlatBlockTree::root) {
+        FlatBlockTreeBuilder builder;
+        int open = 0;
+        bool balanced = true;
+        for (std::size_t i = m_blocks.begin(enclosing) + 1; i < m_blocks.end(enclosing) && balanced; ++i) {
+            if (BlockTreeBuilder::begins_block(m_cst[i].kind)) ++open;
+            else if (BlockTreeBuilder::ends_block(m_cst[i].kind)) balanced = open-- > 0;
+            builder.on_node(m_cst[i]);
+        }
+
+        if (balanced && open == 0)
+            m_blocks.replace_children(enclosing, builder.tree);
+        else
+            enclosing = FlatBlockTree::root;
+    }
+    if (!same_shape && enclosing == FlatBlockTree::root)
+        m_blocks = FlatBlockTreeBuilder::build(m_cst);
+
+    return {s0, removed, inserted, !same_shape, same_shape ? FlatBlockTree::none : enclosing};
+}
+
+// ============================================================
+// Queries
+// ============================================================
+
+std::string IncrementalDocument::text() const {
+    std::string out;
+    out.reserve(m_size);
+    for (const auto &piece : m_pieces) out += piece->text;
+    return out;
+}
+
+int IncrementalDocument::first_line(std::size_t i) const noexcept {
+    int line = 1;
+    for (std::size_t k = 0; k < i; ++k) line += m_pieces[k]->lines;
+    return line;
+}
+
+std::size_t IncrementalDocument::line_at(std::size_t offset) const noexcept {
+    const auto it = std::ranges::upper_bound(m_offsets, offset);
+    return static_cast<std::size_t>(it - m_offsets.begin()) - 1;
+}
+
+std::string IncrementalDocument::format(const FortranFormatter &formatter) const {
+    OutputWriter out(FortranFormatter::estimate(m_size));
+    FormatState state;
+    for (std::size_t i = 0; i < m_pieces.size(); ++i)
+        formatter.emit_line(m_pieces[i]->text, m_pieces[i]->line.tokens, m_cst[i].kind, out, state);
+    return out.take();
+}
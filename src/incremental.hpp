@@ -0,0 +1,113 @@
+#ifndef FORMAT_INCREMENTAL_HPP
+#define FORMAT_INCREMENTAL_HPP
+
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "block_tree.hpp"
+#include "cst_node.hpp"
+#include "formatter.hpp"
+#include "unwrapped_line.hpp"
+
+// ============================================================
+// Incremental Document
+// ============================================================
+//
+// A parsed source that is kept up to date under text edits. The text is
+// held as one piece per logical line, cut at the same safe split points
+// as SplitScanner, and each piece owns its text, its UnwrappedLine and
+// its CSTNode. An edit re-tokenizes only the pieces it touches, plus the
+// following pieces up to the next split point that still lines up with
+// an old one, e.g. all lines of a string literal that the edit opened.
+// The affected nodes are reclassified, prev_kind is repaired up to the
+// next real node, and the block tree is patched in place. If the
+// sequence of block begins and ends in the edited lines changed, only
+// the contents of the innermost block around them are rebuilt.
+//
+// An edit still costs time that grows with the file in these cases:
+//
+//   - the pieces, offsets and nodes after the edit move when it changes
+//     the number of lines, and their offsets, node indices and block
+//     begins and ends are shifted (plain integers, front to back);
+//   - rebuilding a block's contents renumbers the blocks after it;
+//   - an edit that leaves its block with an end line too many or too
+//     few, or that is not inside any closed block, changes which block
+//     every later end line closes, and rebuilds the whole tree.
+//
+// first_line() is O(i), and text() and format() are O(file).
+//
+// Token::line in a piece counts from the piece's first physical line
+// (1 for the first piece, 2 for the others, whose tokenizer resumes
+// after a Newline); first_line() gives the line in the whole text.
+
+struct TextEdit {
+    std::size_t offset = 0;       // byte offset into the current text
+    std::size_t length = 0;       // bytes replaced
+    std::string_view replacement;
+};
+
+struct EditResult {
+    std::size_t first = 0;      // first logical line replaced
+    std::size_t removed = 0;    // logical lines removed
+    std::size_t inserted = 0;   // logical lines inserted in their place
+    bool tree_rebuilt = false;  // the block structure changed
+    // The block whose contents were rebuilt (FlatBlockTree::root for the
+    // whole tree), or FlatBlockTree::none if tree_rebuilt is false.
+    uint32_t rebuilt_block = FlatBlockTree::none;
+};
+
+class IncrementalDocument {
+public:
+    explicit IncrementalDocument(std::string_view text);
+
+    IncrementalDocument(const IncrementalDocument &) = delete;
+    IncrementalDocument &operator=(const IncrementalDocument &) = delete;
+    IncrementalDocument(IncrementalDocument &&) noexcept = default;
+    IncrementalDocument &operator=(IncrementalDocument &&) noexcept = default;
+
+    // Replaces `length` bytes at `offset`. Throws std::out_of_range if
+    // the range is not inside the text.
+    EditResult apply(const TextEdit &edit);
+
+    // Logical lines; the last one holds whatever follows the final
+    // newline, as with UnwrappedLineParser::parse.
+    [[nodiscard]] std::size_t size() const noexcept { return m_pieces.size(); }
+    const UnwrappedLine &operator[](std::size_t i) const noexcept { return m_pieces[i]->line; }
+
+    [[nodiscard]] std::span<const CSTNode> cst() const noexcept { return m_cst; }
+    [[nodiscard]] const FlatBlockTree &blocks() const noexcept { return m_blocks; }
+
+    [[nodiscard]] std::size_t text_size() const noexcept { return m_size; }
+    [[nodiscard]] std::string text() const;
+    [[nodiscard]] std::string_view line_text(std::size_t i) const noexcept { return m_pieces[i]->text; }
+    [[nodiscard]] std::size_t line_offset(std::size_t i) const noexcept { return m_offsets[i]; }
+
+    // Physical line (1-based) on which logical line i starts. O(i).
+    [[nodiscard]] int first_line(std::size_t i) const noexcept;
+
+    // Logical line holding byte `offset` (the last line for the end).
+    [[nodiscard]] std::size_t line_at(std::size_t offset) const noexcept;
+
+    [[nodiscard]] std::string format(const FortranFormatter &formatter) const;
+
+private:
+    struct Piece {
+        std::string text;
+        UnwrappedLine line;
+        int lines = 0; // newlines the tokenizer counted in the piece
+    };
+
+    static std::unique_ptr<Piece> make_piece(std::string text, bool first, bool only);
+
+    std::vector<std::unique_ptr<Piece>> m_pieces;
+    std::vector<std::size_t> m_offsets; // start of each piece in the text
+    std::vector<CSTNode> m_cst;
+    FlatBlockTree m_blocks;
+    std::size_t m_size = 0;
+};
+
+#endif // FORMAT_INCREMENTAL_HPP
@@ -0,0 +1 @@
+#include "keywords.hpp"
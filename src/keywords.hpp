@@ -0,0 +1,131 @@
+#ifndef FORMAT_KEYWORDS_HPP
+#define FORMAT_KEYWORDS_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+// ============================================================
+// Keyword Identifiers
+// ============================================================
+
+enum class KeywordId : uint8_t {
+    Unknown,
+    Program,
+    End,
+    Contains,
+    Module,
+    Abstract,
+    Interface,
+    Subroutine,
+    Call,
+    Function,
+    Select,
+    Case,
+    Do,
+    EndDo,
+    If,
+    Then,
+    Else,
+    EndIf,
+    Use,
+    Print,
+    Implicit,
+    None,
+    Integer,
+    Real,
+    Double,
+    Precision,
+    Logical,
+    Recursive,
+    Type,
+    Pure,
+    Count
+};
+
+namespace keywords_detail {
+    // Lowercase spellings, indexed by KeywordId.
+    inline constexpr std::array<std::string_view, static_cast<std::size_t>(KeywordId::Count)> spellings{
+        "", "program", "end", "contains", "module", "abstract", "interface",
+        "subroutine", "call", "function", "select", "case", "do", "enddo", "if",
+        "then", "else", "endif", "use", "print", "implicit", "none", "integer",
+        "real", "double", "precision", "logical", "recursive", "type", "pure"
+    };
+
+    inline constexpr std::size_t table_bits = 6;
+    inline constexpr std::size_t table_size = std::size_t{1} << table_bits;
+
+    // FNV-1a over ASCII-lowercased bytes. OR-ing 0x20 folds only A-Z onto
+    // a-z among the bytes that can ever equal a keyword byte, so the
+    // verifying compare below stays exact.
+    constexpr uint32_t hash(uint32_t seed, std::string_view s) noexcept {
+        uint32_t h = seed;
+        for (char c : s) {
+            h ^= static_cast<unsigned char>(c) | 0x20u;
+            h *= 16777619u;
+        }
+        return h >> (32 - table_bits);
+    }
+
+    constexpr bool collision_free(uint32_t seed) noexcept {
+        std::array<bool, table_size> used{};
+        for (std::size_t id = 1; id < spellings.size(); ++id) {
+            auto slot = hash(seed, spellings[id]);
+            if (used[slot]) return false;
+            used[slot] = true;
+        }
+        return true;
+    }
+
+    consteval uint32_t find_seed() {
+        for (uint32_t seed = 2166136261u;; ++seed)
+            if (collision_free(seed)) return seed;
+    }
+
+    inline constexpr uint32_t seed = find_seed();
+
+    consteval std::array<KeywordId, table_size> build_table() {
+        std::array<KeywordId, table_size> table{};
+        for (std::size_t id = 1; id < spellings.size(); ++id)
+            table[hash(seed, spellings[id])] = static_cast<KeywordId>(id);
+        return table;
+    }
+
+    inline constexpr std::array<KeywordId, table_size> table = build_table();
+
+    consteval std::size_t max_length() {
+        std::size_t n = 0;
+        for (auto s : spellings) n = s.size() > n ? s.size() : n;
+        return n;
+    }
+
+    inline constexpr std::size_t longest = max_length();
+}
+
+// ============================================================
+// Keyword Lookup
+// ============================================================
+
+// Case-insensitive, allocation-free perfect-hash lookup. Returns
+// KeywordId::Unknown for anything that is not a keyword.
+constexpr KeywordId lookup_keyword(std::string_view s) noexcept {
+    using namespace keywords_detail;
+
+    if (s.size() < 2 || s.size() > longest) return KeywordId::Unknown;
+
+    const KeywordId id = table[hash(seed, s)];
+    const std::string_view k = spellings[static_cast<std::size_t>(id)];
+    if (k.size() != s.size()) return KeywordId::Unknown;
+
+    for (std::size_t i = 0; i < s.size(); ++i)
+        if ((static_cast<unsigned char>(s[i]) | 0x20u) != static_cast<unsigned char>(k[i]))
+            return KeywordId::Unknown;
+
+    return id;
+}
+
+constexpr std::string_view keyword_spelling(KeywordId id) noexcept {
+    return keywords_detail::spellings[static_cast<std::size_t>(id)];
+}
+
+#endif // FORMAT_KEYWORDS_HPP
@@ -0,0 +1,83 @@
+#ifndef FORMAT_LINE_INDEX_HPP
+#define FORMAT_LINE_INDEX_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "scan.hpp"
+
+struct SourcePosition {
+    int line = 1;
+    int column = 1;
+
+    bool operator==(const SourcePosition &) const = default;
+};
+
+// ============================================================
+// Line Index
+// ============================================================
+//
+// Byte offsets of the physical line starts of a source, found in one
+// pass with the newline scanner. Line and column of any offset are then
+// a binary search away, so token storage can keep offsets only.
+//
+// Positions are physical: a character literal that runs over a raw
+// newline ends a line here, while the tokenizer keeps counting its
+// columns from the line the literal started on.
+
+class LineIndex {
+public:
+    LineIndex() : m_starts{0} {}
+
+    explicit LineIndex(std::string_view source, int first_line = 1) : m_first_line(first_line) {
+        if (source.size() > UINT32_MAX)
+            throw std::length_error("LineIndex: source larger than 4 GiB");
+
+        m_starts.reserve(source.size() / 32 + 1);
+        m_starts.push_back(0);
+
+        const char *p = source.data();
+        std::size_t at = 0;
+        while (true) {
+            at += count_until_newline(p + at, source.size() - at);
+            if (at == source.size()) break;
+            m_starts.push_back(static_cast<uint32_t>(++at));
+        }
+    }
+
+    // Number of lines; a trailing newline starts one more (empty) line.
+    [[nodiscard]] std::size_t size() const noexcept { return m_starts.size(); }
+    [[nodiscard]] int first_line() const noexcept { return m_first_line; }
+
+    [[nodiscard]] uint32_t line_start(int line) const noexcept {
+        return m_starts[static_cast<std::size_t>(line - m_first_line)];
+    }
+
+    [[nodiscard]] int line_of(uint32_t offset) const noexcept {
+        return m_first_line + static_cast<int>(slot(offset));
+    }
+
+    [[nodiscard]] int column_of(uint32_t offset) const noexcept {
+        return static_cast<int>(offset - m_starts[slot(offset)]) + 1;
+    }
+
+    [[nodiscard]] SourcePosition position(uint32_t offset) const noexcept {
+        const auto s = slot(offset);
+        return {m_first_line + static_cast<int>(s), static_cast<int>(offset - m_starts[s]) + 1};
+    }
+
+private:
+    // Index of the last line start at or before offset.
+    [[nodiscard]] std::size_t slot(uint32_t offset) const noexcept {
+        const auto it = std::upper_bound(m_starts.begin(), m_starts.end(), offset);
+        return static_cast<std::size_t>(it - m_starts.begin()) - 1;
+    }
+
+    std::vector<uint32_t> m_starts;
+    int m_first_line = 1;
+};
+
+#endif // FORMAT_LINE_INDEX_HPP
@@ -0,0 +1,226 @@
+#ifndef FORMAT_PACKED_TOKENS_HPP
+#define FORMAT_PACKED_TOKENS_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "line_index.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+
+// ============================================================
+// Packed Token
+// ============================================================
+//
+// A Token in 12 bytes instead of 40. The text is a 32-bit offset and a
+// 16-bit length into the source; line and column are recovered from the
+// offset through a LineIndex. A spelling that does not fit (longer than
+// 64 KiB, or not in the source at all, like a merged "- 1") has the
+// length `spilled` and is kept in the owning PackedTokens' side table.
+
+struct PackedToken {
+    static constexpr uint16_t spilled = UINT16_MAX;
+
+    uint32_t offset = 0;
+    uint16_t length = 0;
+    TokenKind kind = TokenKind::Unknown;
+    KeywordId keyword = KeywordId::Unknown;
+    Symbol symbol{};
+};
+
+static_assert(sizeof(PackedToken) == 12);
+
+// ============================================================
+// Packed Tokens
+// ============================================================
+//
+// A token stream of PackedTokens over one source. Elements are
+// materialized as Token values on access, with physical positions (see
+// LineIndex); kind() and keyword() read the packed token only.
+
+class PackedTokens {
+public:
+    // Yields Token values, so it is a C++20 forward iterator but only an
+    // input iterator to pre-ranges code.
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using reference = Token;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(const PackedTokens *tokens, uint32_t index) : m_tokens(tokens), m_index(index) {}
+
+        Token operator*() const noexcept { return (*m_tokens)[m_index]; }
+        iterator &operator++() noexcept { ++m_index; return *this; }
+        iterator operator++(int) noexcept { auto it = *this; ++m_index; return it; }
+        bool operator==(const iterator &) const = default;
+
+    private:
+        const PackedTokens *m_tokens = nullptr;
+        uint32_t m_index = 0;
+    };
+
+    explicit PackedTokens(std::string_view source) : m_source(source) {
+        if (source.size() > UINT32_MAX)
+            throw std::length_error("PackedTokens: source larger than 4 GiB");
+        m_lines = LineIndex(source);
+    }
+
+    static PackedTokens from_source(std::string_view source, SymbolTable *symbols = nullptr) {
+        PackedTokens tokens(source);
+        tokens.reserve(source.size() / 4);
+        FortranTokenizer tz(source, symbols);
+        tz.tokenize_into(tokens);
+        return tokens;
+    }
+
+    void reserve(std::size_t n) { m_tokens.reserve(n); }
+
+    // `extent` is the source the token was lexed from (see
+    // FortranTokenizer::tokenize_into); the token is placed at its start.
+    void push_back(const Token &t, std::string_view extent) {
+        PackedToken p{0, 0, t.kind, t.keyword, t.symbol};
+
+        if (in_source(t.text)) {
+            p.offset = offset_of(t.text);
+            if (t.text.size() < PackedToken::spilled)
+                p.length = static_cast<uint16_t>(t.text.size());
+            else
+                spill(p, t.text);
+        } else {
+            // Nothing in the source to point at: stay where the previous
+            // token ended.
+            p.offset = in_source(extent) ? offset_of(extent) : end_of_last();
+            spill(p, t.text);
+        }
+
+        m_tokens.push_back(p);
+    }
+
+    void push_back(const Token &t) { push_back(t, t.text); }
+
+    [[nodiscard]] size_t size() const noexcept { return m_tokens.size(); }
+    [[nodiscard]] bool empty() const noexcept { return m_tokens.empty(); }
+    [[nodiscard]] std::string_view source() const noexcept { return m_source; }
+    [[nodiscard]] std::span<const PackedToken> packed() const noexcept { return m_tokens; }
+    [[nodiscard]] const LineIndex &line_index() const noexcept { return m_lines; }
+
+    [[nodiscard]] TokenKind kind(std::size_t i) const noexcept { return m_tokens[i].kind; }
+    [[nodiscard]] KeywordId keyword(std::size_t i) const noexcept { return m_tokens[i].keyword; }
+    [[nodiscard]] Symbol symbol(std::size_t i) const noexcept { return m_tokens[i].symbol; }
+    [[nodiscard]] uint32_t offset(std::size_t i) const noexcept { return m_tokens[i].offset; }
+
+    [[nodiscard]] std::string_view text(std::size_t i) const noexcept {
+        const PackedToken &p = m_tokens[i];
+        if (p.length == PackedToken::spilled) return spilled_text(i);
+        return m_source.substr(p.offset, p.length);
+    }
+
+    // Binary search over the line starts.
+    [[nodiscard]] SourcePosition position(std::size_t i) const noexcept {
+        return m_lines.position(m_tokens[i].offset);
+    }
+
+    Token operator[](std::size_t i) const noexcept {
+        const PackedToken &p = m_tokens[i];
+        const auto at = position(i);
+        return Token{p.kind, text(i), at.line, at.column, p.keyword, p.symbol};
+    }
+
+    [[nodiscard]] iterator begin() const noexcept { return {this, 0}; }
+    [[nodiscard]] iterator end() const noexcept { return {this, static_cast<uint32_t>(size())}; }
+
+    // Bytes held for the tokens, side table included.
+    [[nodiscard]] std::size_t memory_bytes() const noexcept {
+        return m_tokens.capacity() * sizeof(PackedToken) + m_spilled.capacity() * sizeof(Spilled);
+    }
+
+private:
+    struct Spilled {
+        uint32_t index; // of the token; increasing
+        std::string_view text;
+    };
+
+    [[nodiscard]] bool in_source(std::string_view s) const noexcept {
+        const auto *base = m_source.data();
+        return s.data() >= base && s.data() + s.size() <= base + m_source.size();
+    }
+
+    [[nodiscard]] uint32_t offset_of(std::string_view s) const noexcept {
+        return static_cast<uint32_t>(s.data() - m_source.data());
+    }
+
+    [[nodiscard]] uint32_t end_of_last() const noexcept {
+        if (m_tokens.empty()) return 0;
+        const auto last = m_tokens.size() - 1;
+        if (m_tokens[last].length != PackedToken::spilled)
+            return m_tokens[last].offset + m_tokens[last].length;
+        return m_tokens[last].offset;
+    }
+
+    void spill(PackedToken &p, std::string_view text) {
+        p.length = PackedToken::spilled;
+        m_spilled.push_back({static_cast<uint32_t>(m_tokens.size()), text});
+    }
+
+    [[nodiscard]] std::string_view spilled_text(std::size_t i) const noexcept {
+        const auto it = std::ranges::lower_bound(m_spilled, static_cast<uint32_t>(i), {}, &Spilled::index);
+        return it->text;
+    }
+
+    std::string_view m_source;
+    LineIndex m_lines;
+    std::vector<PackedToken> m_tokens;
+    std::vector<Spilled> m_spilled;
+};
+
+// ============================================================
+// Packed Token View
+// ============================================================
+//
+// Non-owning handle over a PackedTokens: the Source of the line tables
+// and of the line parser for packed input. The tokens must outlive it.
+
+class PackedTokenView {
+public:
+    PackedTokenView() = default;
+    PackedTokenView(const PackedTokens &tokens) : m_tokens(&tokens) {}
+
+    [[nodiscard]] size_t size() const noexcept { return m_tokens ? m_tokens->size() : 0; }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    Token operator[](std::size_t i) const noexcept { return (*m_tokens)[i]; }
+    [[nodiscard]] TokenKind kind(std::size_t i) const noexcept { return m_tokens->kind(i); }
+
+    [[nodiscard]] PackedTokens::iterator begin() const noexcept {
+        return m_tokens ? m_tokens->begin() : PackedTokens::iterator{};
+    }
+    [[nodiscard]] PackedTokens::iterator end() const noexcept {
+        return m_tokens ? m_tokens->end() : PackedTokens::iterator{};
+    }
+
+private:
+    const PackedTokens *m_tokens = nullptr;
+};
+
+template<>
+inline constexpr bool std::ranges::enable_borrowed_range<PackedTokenView> = true;
+
+template<>
+inline constexpr bool std::ranges::enable_view<PackedTokenView> = true;
+
+using PackedLineTokens = BasicLineTokens<PackedTokenView>;
+using PackedLineView = BasicLineView<PackedTokenView>;
+using PackedLineTable = BasicLineTable<PackedTokenView>;
+using PackedLineParser = BasicUnwrappedLineParser<PackedTokenView>;
+
+#endif // FORMAT_PACKED_TOKENS_HPP
@@ -0,0 +1,110 @@
+#ifndef FORMAT_PARALLEL_CST_HPP
+#define FORMAT_PARALLEL_CST_HPP
+
+#include <algorithm>
+#include <numeric>
+#include <span>
+#include <vector>
+
+#include "cst.hpp"
+#include "thread_pool.hpp"
+
+// ============================================================
+// Parallel CST
+// ============================================================
+//
+// build_cst on a WorkStealingPool, in three passes over chunks of
+// `chunk_lines` lines:
+//
+//   1. classify every line, in parallel, and note the last real kind of
+//      each chunk;
+//   2. a sequential pass over those per-chunk kinds yields the kind
+//      carried into each chunk;
+//   3. fill prev_kind from the carried kind, in parallel.
+//
+// The result equals build_cst. A concurrent() visitor is called from the
+// workers during pass 3; any other visitor is called afterwards, in line
+// order, on the calling thread.
+
+inline constexpr std::size_t default_cst_chunk = 4096;
+
+namespace parallel_cst_detail {
+    inline bool is_real(NodeKind k) noexcept {
+        return k != NodeKind::Blank && k != NodeKind::Unknown;
+    }
+
+    inline const UnwrappedLine *line_pointer(std::span<const UnwrappedLine> lines, std::size_t i) {
+        return &lines[i];
+    }
+
+    inline const UnwrappedLine *line_pointer(const LineTable &, std::size_t) {
+        return nullptr;
+    }
+
+    template<typename Lines>
+    std::vector<CSTNode> build(const Lines &lines, WorkStealingPool &pool,
+                               CSTVisitor *visitor, std::size_t chunk_lines) {
+        const std::size_t n = lines.size();
+        chunk_lines = std::max<std::size_t>(chunk_lines, 1);
+        const std::size_t chunks = (n + chunk_lines - 1) / chunk_lines;
+
+        std::vector<CSTNode> cst(n);
+        std::vector<NodeKind> last_real(chunks, NodeKind::Unknown);
+        std::vector<uint32_t> order(chunks);
+        std::iota(order.begin(), order.end(), 0u);
+
+        pool.run(order, [&](unsigned, uint32_t c) {
+            const std::size_t end = std::min(n, (c + 1) * chunk_lines);
+            for (std::size_t i = c * chunk_lines; i < end; ++i) {
+                CSTNode &node = cst[i];
+                node.line = line_pointer(lines, i);
+                node.index = i;
+                node.kind = classify(lines[i]);
+                if (is_real(node.kind)) last_real[c] = node.kind;
+            }
+        });
+
+        // carried[c]: last real kind before chunk c
+        std::vector<NodeKind> carried(chunks, NodeKind::Unknown);
+        for (std::size_t c = 1; c < chunks; ++c)
+            carried[c] = is_real(last_real[c - 1]) ? last_real[c - 1] : carried[c - 1];
+
+        const bool concurrent = visitor && visitor->concurrent();
+
+        pool.run(order, [&](unsigned, uint32_t c) {
+            NodeKind last = carried[c];
+            const std::size_t end = std::min(n, (c + 1) * chunk_lines);
+            for (std::size_t i = c * chunk_lines; i < end; ++i) {
+                CSTNode &node = cst[i];
+                node.prev_kind = last;
+                if (is_real(node.kind)) last = node.kind;
+                if (concurrent) visitor->on_node(node);
+            }
+        });
+
+        if (visitor && !concurrent)
+            for (const auto &node : cst) visitor->on_node(node);
+
+        return cst;
+    }
+}
+
+inline std::vector<CSTNode>
+build_cst_parallel(std::span<const UnwrappedLine> lines,
+                   WorkStealingPool &pool,
+                   CSTVisitor *visitor = nullptr,
+                   std::size_t chunk_lines = default_cst_chunk)
+{
+    return parallel_cst_detail::build(lines, pool, visitor, chunk_lines);
+}
+
+inline std::vector<CSTNode>
+build_cst_parallel(const LineTable &lines,
+                   WorkStealingPool &pool,
+                   CSTVisitor *visitor = nullptr,
+                   std::size_t chunk_lines = default_cst_chunk)
+{
+    return parallel_cst_detail::build(lines, pool, visitor, chunk_lines);
+}
+
+#endif // FORMAT_PARALLEL_CST_HPP
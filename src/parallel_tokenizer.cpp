@@ -0,0 +1,79 @@
+#include "parallel_tokenizer.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+#include "split_scanner.hpp"
+
+std::vector<std::size_t> split_points(std::string_view source, std::size_t chunk_size) {
+    chunk_size = std::max<std::size_t>(chunk_size, 1);
+
+    std::vector<std::size_t> cuts{0};
+    SplitScanner scanner;
+    std::size_t scanned = 0;
+
+    while (scanned < source.size()) {
+        const std::size_t end = std::min(source.size(), scanned + chunk_size);
+        if (std::size_t cut = scanner.scan(source.substr(scanned, end - scanned))) {
+            // a cut at the very end of the source would leave an empty piece
+            if (scanned + cut < source.size() && scanned + cut > cuts.back())
+                cuts.push_back(scanned + cut);
+        }
+        scanned = end;
+    }
+
+    cuts.push_back(source.size());
+    return cuts;
+}
+
+std::vector<Token> tokenize_parallel(std::string_view source,
+                                     WorkStealingPool &pool,
+                                     SymbolTable *symbols,
+                                     std::size_t chunk_size) {
+    if (source.size() < 2 * chunk_size || pool.size() < 2)
+        return FortranTokenizer(source, symbols).tokenize();
+
+    const auto cuts = split_points(source, chunk_size);
+    const std::size_t pieces = cuts.size() - 1;
+
+    // Every piece but the first resumes after a Newline. Its lines are
+    // numbered from `resumed_line` and shifted once the line count of
+    // the pieces before it is known: newlines inside string literals
+    // do not advance the tokenizer's line, so it cannot be precomputed.
+    constexpr int resumed_line = 2;
+
+    std::vector<std::vector<Token>> parts(pieces);
+    std::vector<uint32_t> order(pieces);
+    std::iota(order.begin(), order.end(), 0u);
+
+    pool.run(order, [&](unsigned, uint32_t i) {
+        const auto piece = source.substr(cuts[i], cuts[i + 1] - cuts[i]);
+        parts[i] = i == 0 ? FortranTokenizer(piece, symbols).tokenize()
+                          : FortranTokenizer(piece, resumed_line, symbols).tokenize();
+    });
+
+    // Each piece's EndOfFile sits on the line where the next piece starts.
+    std::vector<int> shift(pieces, 0);
+    std::vector<std::size_t> offset(pieces + 1, 0);
+    for (std::size_t i = 0; i < pieces; ++i) {
+        const bool last = i + 1 == pieces;
+        offset[i + 1] = offset[i] + parts[i].size() - (last ? 0 : 1);
+        if (!last)
+            shift[i + 1] = parts[i].back().line + shift[i] - resumed_line;
+    }
+
+    std::vector<Token> tokens(offset[pieces]);
+    pool.run(order, [&](unsigned, uint32_t i) {
+        const bool last = i + 1 == pieces;
+        const auto &part = parts[i];
+        const std::size_t n = part.size() - (last ? 0 : 1);
+        Token *out = tokens.data() + offset[i];
+        for (std::size_t k = 0; k < n; ++k) {
+            out[k] = part[k];
+            out[k].line += shift[i];
+        }
+        std::vector<Token>().swap(parts[i]);
+    });
+
+    return tokens;
+}
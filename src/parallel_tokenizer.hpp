@@ -0,0 +1,36 @@
+#ifndef FORMAT_PARALLEL_TOKENIZER_HPP
+#define FORMAT_PARALLEL_TOKENIZER_HPP
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "tokenizer.hpp"
+#include "thread_pool.hpp"
+
+// ============================================================
+// Parallel Tokenization
+// ============================================================
+//
+// Tokenizes one large source on a WorkStealingPool. The text is cut at
+// safe split points (see SplitScanner) roughly `chunk_size` bytes apart,
+// the pieces are tokenized concurrently with resuming tokenizers, and
+// the results are stitched into one vector with line numbers shifted to
+// the whole file. The result is identical to FortranTokenizer::tokenize.
+//
+// Finding the cuts is one sequential pass over the bytes, much cheaper
+// than lexing them; sources smaller than two chunks are tokenized
+// directly.
+
+inline constexpr std::size_t default_tokenize_chunk = 256 * 1024;
+
+// Offsets at which `source` may be cut, about `chunk_size` apart; the
+// first is 0, the last is source.size().
+std::vector<std::size_t> split_points(std::string_view source, std::size_t chunk_size);
+
+std::vector<Token> tokenize_parallel(std::string_view source,
+                                     WorkStealingPool &pool,
+                                     SymbolTable *symbols = nullptr,
+                                     std::size_t chunk_size = default_tokenize_chunk);
+
+#endif // FORMAT_PARALLEL_TOKENIZER_HPP
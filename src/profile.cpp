@@ -0,0 +1,181 @@
+#include "profile.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <new>
+
+// ============================================================
+// Allocation Counting
+// ============================================================
+
+namespace {
+    thread_local ThreadAllocCounts t_allocs;
+}
+
+ThreadAllocCounts thread_alloc_counts() noexcept { return t_allocs; }
+
+#ifdef FORMAT_ENABLE_PROFILING
+namespace {
+    void *counted_allocate(std::size_t size, std::size_t align) {
+        ++t_allocs.allocations;
+        t_allocs.bytes += size;
+
+        if (size == 0) size = 1;
+        void *p = align > __STDCPP_DEFAULT_NEW_ALIGNMENT__
+                      ? std::aligned_alloc(align, (size + align - 1) / align * align)
+                      : std::malloc(size);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+}
+
+void *operator new(std::size_t size) { return counted_allocate(size, 0); }
+void *operator new[](std::size_t size) { return counted_allocate(size, 0); }
+void *operator new(std::size_t size, std::align_val_t align) { return counted_allocate(size, static_cast<std::size_t>(align)); }
+void *operator new[](std::size_t size, std::align_val_t align) { return counted_allocate(size, static_cast<std::size_t>(align)); }
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete[](void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t) noexcept { std::free(p); }
+void operator delete(void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+#endif
+
+// ============================================================
+// Profiler
+// ============================================================
+
+Profiler &Profiler::global() {
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::record(const ProfileEvent &event) {
+    std::lock_guard lock(m_mutex);
+    m_events.push_back(event);
+}
+
+void Profiler::clear() {
+    std::lock_guard lock(m_mutex);
+    m_events.clear();
+}
+
+std::vector<ProfileEvent> Profiler::events() const {
+    std::lock_guard lock(m_mutex);
+    return m_events;
+}
+
+uint64_t Profiler::now_ns() const noexcept {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_epoch).count());
+}
+
+uint32_t Profiler::thread_index() noexcept {
+    static std::atomic<uint32_t> next{0};
+    thread_local const uint32_t index = next++;
+    return index;
+}
+
+namespace {
+    void append(std::string &out, const char *format, auto... args) {
+        char buf[512];
+        const int n = std::snprintf(buf, sizeof buf, format, args...);
+        out.append(buf, std::min(static_cast<std::size_t>(std::max(n, 0)), sizeof buf - 1));
+    }
+
+    unsigned long long ull(uint64_t v) { return v; }
+
+    // Stage names and units are identifiers; nothing needs escaping.
+    std::string quoted(std::string_view s) {
+        return '"' + std::string(s) + '"';
+    }
+}
+
+std::string Profiler::to_json() const {
+    const auto events = this->events();
+
+    struct Totals {
+        std::string_view unit;
+        uint64_t calls = 0, duration_ns = 0, items = 0, allocations = 0, alloc_bytes = 0;
+    };
+    std::map<std::string_view, Totals> stages;
+
+    std::string out = "{\n  \"events\": [";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const auto &e = events[i];
+        append(out, "%s\n    {\"stage\": %s, \"thread\": %u, \"start_ns\": %llu, \"duration_ns\": %llu, "
+                    "\"items\": %llu, \"unit\": %s, \"allocations\": %llu, \"alloc_bytes\": %llu}",
+               i ? "," : "", quoted(e.stage).c_str(), e.thread, ull(e.start_ns), ull(e.duration_ns),
+               ull(e.items), quoted(e.unit).c_str(), ull(e.allocations), ull(e.alloc_bytes));
+
+        auto &t = stages[e.stage];
+        t.unit = e.unit;
+        ++t.calls;
+        t.duration_ns += e.duration_ns;
+        t.items += e.items;
+        t.allocations += e.allocations;
+        t.alloc_bytes += e.alloc_bytes;
+    }
+    out += events.empty() ? "],\n" : "\n  ],\n";
+
+    out += "  \"stages\": {";
+    bool first = true;
+    for (const auto &[stage, t] : stages) {
+        append(out, "%s\n    %s: {\"calls\": %llu, \"duration_ns\": %llu, \"items\": %llu, \"unit\": %s, "
+                    "\"allocations\": %llu, \"alloc_bytes\": %llu}",
+               first ? "" : ",", quoted(stage).c_str(), ull(t.calls), ull(t.duration_ns), ull(t.items),
+               quoted(t.unit).c_str(), ull(t.allocations), ull(t.alloc_bytes));
+        first = false;
+    }
+    out += stages.empty() ? "}\n}\n" : "\n  }\n}\n";
+    return out;
+}
+
+std::string Profiler::to_chrome_trace() const {
+    const auto events = this->events();
+
+    std::string out = "{\"traceEvents\": [";
+    for (std::size_t i = 0; i < events.size(); ++i) {
+        const auto &e = events[i];
+        append(out, "%s\n  {\"name\": %s, \"cat\": \"format\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, "
+                    "\"ts\": %.3f, \"dur\": %.3f, \"args\": {%s: %llu, \"allocations\": %llu, \"alloc_bytes\": %llu}}",
+               i ? "," : "", quoted(e.stage).c_str(), e.thread,
+               static_cast<double>(e.start_ns) / 1e3, static_cast<double>(e.duration_ns) / 1e3,
+               quoted(e.unit).c_str(), ull(e.items), ull(e.allocations), ull(e.alloc_bytes));
+    }
+    out += "\n], \"displayTimeUnit\": \"ms\"}\n";
+    return out;
+}
+
+// ============================================================
+// Profile Scope
+// ============================================================
+
+ProfileScope::ProfileScope(std::string_view stage, std::string_view unit) noexcept
+    : m_allocs(thread_alloc_counts()) {
+    m_event.stage = stage;
+    m_event.unit = unit;
+    m_event.thread = Profiler::thread_index();
+    m_event.start_ns = Profiler::global().now_ns();
+}
+
+ProfileScope::~ProfileScope() {
+    const auto allocs = thread_alloc_counts();
+    m_event.duration_ns = Profiler::global().now_ns() - m_event.start_ns;
+    m_event.allocations = allocs.allocations - m_allocs.allocations;
+    m_event.alloc_bytes = allocs.bytes - m_allocs.bytes;
+    try {
+        // The profiler's own bookkeeping is not charged to the pipeline.
+        const auto saved = t_allocs;
+        Profiler::global().record(m_event);
+        t_allocs = saved;
+    } catch (...) {
+        // dropping an event is better than terminating
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef FORMAT_PROFILE_HPP
+#define FORMAT_PROFILE_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// ============================================================
+// Pipeline Profiling
+// ============================================================
+//
+// Each pipeline stage (tokenize, parse, build_cst, block_tree, emit)
+// opens a ProfileScope that records its wall time, how many items it
+// produced and how many allocations its thread made meanwhile, into the
+// global Profiler. The scopes are compiled in only when
+// FORMAT_ENABLE_PROFILING is defined (the CMake option of that name);
+// otherwise the macros below expand to nothing and cost nothing.
+//
+// The Profiler itself always exists, so a build without profiling
+// simply exports an empty report. Allocations are counted by replacing
+// the global operator new, again only in profiling builds.
+
+struct ProfileEvent {
+    std::string_view stage; // string literals only
+    std::string_view unit;  // what `items` counts
+    uint32_t thread = 0;
+    uint64_t start_ns = 0;  // since the profiler was created
+    uint64_t duration_ns = 0;
+    uint64_t items = 0;
+    uint64_t allocations = 0;
+    uint64_t alloc_bytes = 0;
+};
+
+struct ThreadAllocCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+// Allocations made by the calling thread so far; always zero unless
+// built with FORMAT_ENABLE_PROFILING.
+ThreadAllocCounts thread_alloc_counts() noexcept;
+
+class Profiler {
+public:
+    static Profiler &global();
+
+    void record(const ProfileEvent &event);
+    void clear();
+
+    [[nodiscard]] std::vector<ProfileEvent> events() const;
+    [[nodiscard]] uint64_t now_ns() const noexcept;
+
+    // Small, stable numbers for threads, in order of first use.
+    static uint32_t thread_index() noexcept;
+
+    // {"events": [...], "stages": {stage: totals}}
+    [[nodiscard]] std::string to_json() const;
+
+    // Trace-event format, for chrome://tracing or Perfetto.
+    [[nodiscard]] std::string to_chrome_trace() const;
+
+private:
+    Profiler() = default;
+
+    const std::chrono::steady_clock::time_point m_epoch = std::chrono::steady_clock::now();
+    mutable std::mutex m_mutex;
+    std::vector<ProfileEvent> m_events;
+};
+
+class ProfileScope {
+public:
+    ProfileScope(std::string_view stage, std::string_view unit) noexcept;
+    ~ProfileScope();
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+
+    void items(uint64_t n) noexcept { m_event.items = n; }
+
+private:
+    ProfileEvent m_event;
+    ThreadAllocCounts m_allocs;
+};
+
+#ifdef FORMAT_ENABLE_PROFILING
+#define FORMAT_PROFILE_SCOPE(stage, unit) ProfileScope format_profile_scope_(stage, unit)
+#define FORMAT_PROFILE_ITEMS(n) format_profile_scope_.items(n)
+#else
+#define FORMAT_PROFILE_SCOPE(stage, unit) ((void)0)
+#define FORMAT_PROFILE_ITEMS(n) ((void)0)
+#endif
+
+#endif // FORMAT_PROFILE_HPP
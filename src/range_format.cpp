@@ -0,0 +1,133 @@
+#include "range_format.hpp"
+
+#include <algorithm>
+
+#include "block_tree.hpp"
+#include "cst.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+
+namespace {
+    // Innermost block containing logical line `a` and, if it is not the
+    // root, line `b`.
+    uint32_t enclosing_block(const FlatBlockTree &tree, std::size_t a, std::size_t b) {
+        const auto contains = [&](uint32_t block, std::size_t line) {
+            if (block == FlatBlockTree::root) return true;
+            const uint32_t end = tree.end(block);
+            return tree.begin(block) <= line && (end == FlatBlockTree::none || line <= end);
+        };
+
+        // Blocks are numbered in the order they begin.
+        const auto begins = tree.begins().subspan(1);
+        const auto it = std::ranges::upper_bound(begins, a);
+        auto block = static_cast<uint32_t>(it - begins.begin()); // last block beginning at or before a
+
+        while (!contains(block, a) || !contains(block, b)) block = tree.parent(block);
+        return block;
+    }
+}
+
+std::vector<Replacement> format_ranges(std::string_view source,
+                                       std::span<const SourceLineRange> ranges,
+                                       const FortranFormatter &formatter) {
+    FortranTokenizer tz(source);
+    const auto tokens = tz.tokenize();
+    const auto lines = UnwrappedLineParser(tokens).parse_ranges();
+    const auto cst = build_cst(lines);
+    const auto tree = FlatBlockTreeBuilder::build(cst);
+
+    // Byte range of each logical line: from the end of the previous one
+    // through its own final Newline.
+    std::vector<std::size_t> line_end(lines.size());
+    for (std::size_t i = 0; i < lines.size(); ++i) {
+        const auto t = lines[i].tokens;
+        line_end[i] = !t.empty() && t.back().kind == TokenKind::Newline
+                          ? static_cast<std::size_t>(t.back().text.data() - source.data()) + 1
+                          : source.size();
+    }
+    const auto line_begin = [&](std::size_t i) { return i == 0 ? 0 : line_end[i - 1]; };
+
+    // Start of each physical line.
+    std::vector<std::size_t> physical{0};
+    for (std::size_t i = 0; i < source.size(); ++i)
+        if (source[i] == '\n') physical.push_back(i + 1);
+
+    // Logical line holding byte `offset`.
+    const auto logical_at = [&](std::size_t offset) {
+        const auto it = std::ranges::upper_bound(line_end, offset);
+        return std::min(static_cast<std::size_t>(it - line_end.begin()), lines.size() - 1);
+    };
+
+    // Widen each range to its block, as [first, last] logical lines.
+    std::vector<std::pair<std::size_t, std::size_t>> spans;
+    for (const auto &r : ranges) {
+        if (r.last < r.first || r.last < 1 || static_cast<std::size_t>(r.first) > physical.size()) continue;
+
+        const auto first = static_cast<std::size_t>(std::max(r.first, 1)) - 1;
+        const auto last = std::min(static_cast<std::size_t>(r.last), physical.size()) - 1;
+        std::size_t a = logical_at(physical[first]);
+        std::size_t b = logical_at(physical[last]);
+
+        if (const uint32_t block = enclosing_block(tree, a, b); block != FlatBlockTree::root) {
+            a = tree.begin(block);
+            b = tree.end(block) == FlatBlockTree::none ? lines.size() - 1 : tree.end(block);
+        }
+        spans.emplace_back(a, b);
+    }
+
+    std::ranges::sort(spans);
+
+    std::vector<Replacement> out;
+    OutputWriter writer(FortranFormatter::estimate(source.size() / 8));
+    std::size_t done = 0; // logical lines before this are handled
+
+    for (auto [a, b] : spans) {
+        a = std::max(a, done);
+        if (a > b) continue;
+
+        // Depth and blank-line run from the lines before the span.
+        FormatState state;
+        if (const uint32_t block = enclosing_block(tree, a, a); block != FlatBlockTree::root) {
+            // a opens `block` or lies inside it
+            state.depth = tree.depth(block) + (tree.begin(block) < a ? 1 : 0);
+        }
+        for (std::size_t i = a; i > 0; --i) {
+            const auto t = lines[i - 1].tokens;
+            if (t.empty() || t.front().kind != TokenKind::Newline) break;
+            ++state.blank_run;
+        }
+
+        for (std::size_t i = a; i <= b; ++i) {
+            writer.clear();
+            formatter.emit_line(source, lines[i].tokens, cst[i].kind, writer, state);
+
+            const std::size_t begin = line_begin(i);
+            const std::size_t length = line_end[i] - begin;
+            const std::string_view formatted = writer.view();
+            if (formatted == source.substr(begin, length)) continue;
+
+            if (!out.empty() && out.back().offset + out.back().length == begin) {
+                out.back().length += length;
+                out.back().text += formatted;
+            } else {
+                out.push_back({begin, length, std::string(formatted)});
+            }
+        }
+        done = b + 1;
+    }
+
+    return out;
+}
+
+std::string apply_replacements(std::string_view source, std::span<const Replacement> replacements) {
+    std::string out;
+    out.reserve(source.size());
+    std::size_t at = 0;
+    for (const auto &r : replacements) {
+        out.append(source.substr(at, r.offset - at));
+        out.append(r.text);
+        at = r.offset + r.length;
+    }
+    out.append(source.substr(at));
+    return out;
+}
@@ -0,0 +1,42 @@
+#ifndef FORMAT_RANGE_FORMAT_HPP
+#define FORMAT_RANGE_FORMAT_HPP
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "formatter.hpp"
+
+// ============================================================
+// Range Formatting
+// ============================================================
+//
+// Formats only the parts of a file around some lines, e.g. the hunks of
+// a diff. Each range is widened to the innermost block that encloses it
+// (see FlatBlockTree), the block is formatted at the depth its ancestors
+// give it, and the result is a list of replacements for the logical
+// lines whose text actually changes. Ranges at file level, outside any
+// block, are formatted as they are.
+
+// Physical lines, 1-based and inclusive, as in a diff hunk.
+struct SourceLineRange {
+    int first = 1;
+    int last = 1;
+};
+
+struct Replacement {
+    std::size_t offset = 0; // into the original source
+    std::size_t length = 0; // bytes replaced
+    std::string text;
+};
+
+// Sorted by offset and non-overlapping.
+std::vector<Replacement> format_ranges(std::string_view source,
+                                       std::span<const SourceLineRange> ranges,
+                                       const FortranFormatter &formatter = FortranFormatter{});
+
+std::string apply_replacements(std::string_view source, std::span<const Replacement> replacements);
+
+#endif // FORMAT_RANGE_FORMAT_HPP
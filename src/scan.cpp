@@ -0,0 +1,309 @@
+#include "scan.hpp"
+
+#include <atomic>
+
+#if !defined(FORMAT_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+#define FORMAT_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+    using ScanFn = std::size_t (*)(const char *, std::size_t) noexcept;
+
+    // ============================================================
+    // Scalar
+    // ============================================================
+
+    inline bool is_blank(char c) noexcept {
+        return c == ' ' || c == '\t';
+    }
+
+    inline bool is_line_end(char c) noexcept {
+        return c == '\n' || c == '\0';
+    }
+
+    inline bool is_newline(char c) noexcept {
+        return c == '\n';
+    }
+
+    inline bool is_identifier_char(char c) noexcept {
+        const auto u = static_cast<unsigned char>(c);
+        return static_cast<unsigned char>((u | 0x20) - 'a') <= 'z' - 'a' ||
+               static_cast<unsigned char>(u - '0') <= 9 || c == '_';
+    }
+
+    template<bool (*Pred)(char) noexcept>
+    std::size_t scalar_run(const char *p, std::size_t n) noexcept {
+        std::size_t i = 0;
+        while (i < n && Pred(p[i])) ++i;
+        return i;
+    }
+
+    template<bool (*Pred)(char) noexcept>
+    std::size_t scalar_until(const char *p, std::size_t n) noexcept {
+        std::size_t i = 0;
+        while (i < n && !Pred(p[i])) ++i;
+        return i;
+    }
+
+    std::size_t blanks_scalar(const char *p, std::size_t n) noexcept {
+        return scalar_run<is_blank>(p, n);
+    }
+
+    std::size_t line_end_scalar(const char *p, std::size_t n) noexcept {
+        return scalar_until<is_line_end>(p, n);
+    }
+
+    std::size_t identifier_scalar(const char *p, std::size_t n) noexcept {
+        return scalar_run<is_identifier_char>(p, n);
+    }
+
+    std::size_t newline_scalar(const char *p, std::size_t n) noexcept {
+        return scalar_until<is_newline>(p, n);
+    }
+
+#ifdef FORMAT_SCAN_X86
+
+    // ============================================================
+    // SSE2 (16 bytes per step)
+    // ============================================================
+    //
+    // Each *_mask16 returns a bitmask with one bit per byte that belongs
+    // to the run; the scan stops at the first clear bit.
+
+    inline unsigned blanks_mask16(__m128i x) noexcept {
+        const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(' ')),
+                                       _mm_cmpeq_epi8(x, _mm_set1_epi8('\t')));
+        return static_cast<unsigned>(_mm_movemask_epi8(m));
+    }
+
+    inline unsigned not_line_end_mask16(__m128i x) noexcept {
+        const __m128i m = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')),
+                                       _mm_cmpeq_epi8(x, _mm_setzero_si128()));
+        return ~static_cast<unsigned>(_mm_movemask_epi8(m)) & 0xFFFFu;
+    }
+
+    inline unsigned not_newline_mask16(__m128i x) noexcept {
+        return ~static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n')))) & 0xFFFFu;
+    }
+
+    // Unsigned range checks via min: (x - lo) <= span  <=>  min(x - lo, span) == x - lo
+    inline unsigned identifier_mask16(__m128i x) noexcept {
+        const __m128i alpha = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+        const __m128i digit = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+        const __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(25)), alpha);
+        const __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+        const __m128i is_under = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(is_alpha, is_digit), is_under)));
+    }
+
+    template<unsigned (*Mask)(__m128i) noexcept>
+    inline bool sse2_steps(const char *p, std::size_t n, std::size_t &i) noexcept {
+        for (; i + 16 <= n; i += 16) {
+            const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+            const unsigned miss = ~Mask(x) & 0xFFFFu;
+            if (miss) {
+                i += static_cast<std::size_t>(__builtin_ctz(miss));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    template<unsigned (*Mask)(__m128i) noexcept, bool (*Pred)(char) noexcept, bool Until>
+    std::size_t sse2_run(const char *p, std::size_t n) noexcept {
+        std::size_t i = 0;
+        if (sse2_steps<Mask>(p, n, i)) return i;
+        if constexpr (Until) return i + scalar_until<Pred>(p + i, n - i);
+        else return i + scalar_run<Pred>(p + i, n - i);
+    }
+
+    std::size_t blanks_sse2(const char *p, std::size_t n) noexcept {
+        return sse2_run<blanks_mask16, is_blank, false>(p, n);
+    }
+
+    std::size_t line_end_sse2(const char *p, std::size_t n) noexcept {
+        return sse2_run<not_line_end_mask16, is_line_end, true>(p, n);
+    }
+
+    std::size_t identifier_sse2(const char *p, std::size_t n) noexcept {
+        return sse2_run<identifier_mask16, is_identifier_char, false>(p, n);
+    }
+
+    std::size_t newline_sse2(const char *p, std::size_t n) noexcept {
+        return sse2_run<not_newline_mask16, is_newline, true>(p, n);
+    }
+
+    // ============================================================
+    // AVX2 (32 bytes per step)
+    // ============================================================
+
+#define FORMAT_AVX2 __attribute__((target("avx2")))
+
+    FORMAT_AVX2 inline unsigned blanks_mask32(__m256i x) noexcept {
+        const __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(' ')),
+                                          _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\t')));
+        return static_cast<unsigned>(_mm256_movemask_epi8(m));
+    }
+
+    FORMAT_AVX2 inline unsigned not_line_end_mask32(__m256i x) noexcept {
+        const __m256i m = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n')),
+                                          _mm256_cmpeq_epi8(x, _mm256_setzero_si256()));
+        return ~static_cast<unsigned>(_mm256_movemask_epi8(m));
+    }
+
+    FORMAT_AVX2 inline unsigned not_newline_mask32(__m256i x) noexcept {
+        return ~static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))));
+    }
+
+    FORMAT_AVX2 inline unsigned identifier_mask32(__m256i x) noexcept {
+        const __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+        const __m256i digit = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+        const __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(25)), alpha);
+        const __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+        const __m256i is_under = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+        return static_cast<unsigned>(_mm256_movemask_epi8(
+            _mm256_or_si256(_mm256_or_si256(is_alpha, is_digit), is_under)));
+    }
+
+    template<unsigned (*Mask32)(__m256i) noexcept, unsigned (*Mask16)(__m128i) noexcept,
+        bool (*Pred)(char) noexcept, bool Until>
+    FORMAT_AVX2 std::size_t avx2_run(const char *p, std::size_t n) noexcept {
+        std::size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+            const unsigned miss = ~Mask32(x);
+            if (miss) return i + static_cast<std::size_t>(__builtin_ctz(miss));
+        }
+        if (sse2_steps<Mask16>(p, n, i)) return i;
+        if constexpr (Until) return i + scalar_until<Pred>(p + i, n - i);
+        else return i + scalar_run<Pred>(p + i, n - i);
+    }
+
+    FORMAT_AVX2 std::size_t blanks_avx2(const char *p, std::size_t n) noexcept {
+        return avx2_run<blanks_mask32, blanks_mask16, is_blank, false>(p, n);
+    }
+
+    FORMAT_AVX2 std::size_t line_end_avx2(const char *p, std::size_t n) noexcept {
+        return avx2_run<not_line_end_mask32, not_line_end_mask16, is_line_end, true>(p, n);
+    }
+
+    FORMAT_AVX2 std::size_t identifier_avx2(const char *p, std::size_t n) noexcept {
+        return avx2_run<identifier_mask32, identifier_mask16, is_identifier_char, false>(p, n);
+    }
+
+    FORMAT_AVX2 std::size_t newline_avx2(const char *p, std::size_t n) noexcept {
+        return avx2_run<not_newline_mask32, not_newline_mask16, is_newline, true>(p, n);
+    }
+
+#undef FORMAT_AVX2
+
+#endif // FORMAT_SCAN_X86
+
+    // ============================================================
+    // Dispatch
+    // ============================================================
+
+    bool supports(ScanIsa isa) noexcept {
+        switch (isa) {
+            case ScanIsa::Scalar: return true;
+#ifdef FORMAT_SCAN_X86
+            case ScanIsa::SSE2: return true;
+            case ScanIsa::AVX2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2");
+#endif
+            default: return false;
+        }
+    }
+
+    ScanIsa best_isa() noexcept {
+        if (supports(ScanIsa::AVX2)) return ScanIsa::AVX2;
+        if (supports(ScanIsa::SSE2)) return ScanIsa::SSE2;
+        return ScanIsa::Scalar;
+    }
+
+    std::size_t blanks_resolve(const char *p, std::size_t n) noexcept;
+    std::size_t line_end_resolve(const char *p, std::size_t n) noexcept;
+    std::size_t identifier_resolve(const char *p, std::size_t n) noexcept;
+    std::size_t newline_resolve(const char *p, std::size_t n) noexcept;
+
+    // Start out pointing at resolvers, so the first call (from any thread,
+    // at any point of static initialization) picks the implementation.
+    std::atomic<ScanFn> g_blanks{blanks_resolve};
+    std::atomic<ScanFn> g_line_end{line_end_resolve};
+    std::atomic<ScanFn> g_identifier{identifier_resolve};
+    std::atomic<ScanFn> g_newline{newline_resolve};
+    std::atomic<ScanIsa> g_isa{ScanIsa::Scalar};
+
+    void install(ScanIsa isa) noexcept {
+        ScanFn blanks = blanks_scalar, line_end = line_end_scalar, identifier = identifier_scalar;
+        ScanFn newline = newline_scalar;
+#ifdef FORMAT_SCAN_X86
+        if (isa == ScanIsa::SSE2) {
+            blanks = blanks_sse2;
+            line_end = line_end_sse2;
+            identifier = identifier_sse2;
+            newline = newline_sse2;
+        } else if (isa == ScanIsa::AVX2) {
+            blanks = blanks_avx2;
+            line_end = line_end_avx2;
+            identifier = identifier_avx2;
+            newline = newline_avx2;
+        }
+#endif
+        g_blanks.store(blanks, std::memory_order_relaxed);
+        g_line_end.store(line_end, std::memory_order_relaxed);
+        g_identifier.store(identifier, std::memory_order_relaxed);
+        g_newline.store(newline, std::memory_order_relaxed);
+        g_isa.store(isa, std::memory_order_relaxed);
+    }
+
+    std::size_t blanks_resolve(const char *p, std::size_t n) noexcept {
+        install(best_isa());
+        return g_blanks.load(std::memory_order_relaxed)(p, n);
+    }
+
+    std::size_t line_end_resolve(const char *p, std::size_t n) noexcept {
+        install(best_isa());
+        return g_line_end.load(std::memory_order_relaxed)(p, n);
+    }
+
+    std::size_t identifier_resolve(const char *p, std::size_t n) noexcept {
+        install(best_isa());
+        return g_identifier.load(std::memory_order_relaxed)(p, n);
+    }
+
+    std::size_t newline_resolve(const char *p, std::size_t n) noexcept {
+        install(best_isa());
+        return g_newline.load(std::memory_order_relaxed)(p, n);
+    }
+}
+
+std::size_t count_blanks(const char *p, std::size_t n) noexcept {
+    return g_blanks.load(std::memory_order_relaxed)(p, n);
+}
+
+std::size_t count_until_line_end(const char *p, std::size_t n) noexcept {
+    return g_line_end.load(std::memory_order_relaxed)(p, n);
+}
+
+std::size_t count_identifier_chars(const char *p, std::size_t n) noexcept {
+    return g_identifier.load(std::memory_order_relaxed)(p, n);
+}
+
+std::size_t count_until_newline(const char *p, std::size_t n) noexcept {
+    return g_newline.load(std::memory_order_relaxed)(p, n);
+}
+
+ScanIsa active_scan_isa() noexcept {
+    if (g_blanks.load(std::memory_order_relaxed) == blanks_resolve)
+        install(best_isa());
+    return g_isa.load(std::memory_order_relaxed);
+}
+
+bool force_scan_isa(ScanIsa isa) noexcept {
+    if (!supports(isa)) return false;
+    install(isa);
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef FORMAT_SCAN_HPP
+#define FORMAT_SCAN_HPP
+
+#include <cstddef>
+
+// ============================================================
+// Byte-run Scanners
+// ============================================================
+//
+// Each scanner returns the length of the run starting at p, looking at
+// no more than n bytes. On x86-64 they process 16 (SSE2) or 32 (AVX2)
+// bytes per step; the implementation is chosen once at startup from
+// the CPU features, with a scalar fallback everywhere else. Define
+// FORMAT_NO_SIMD to build the scalar versions only.
+
+enum class ScanIsa {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// Blanks: ' ' and '\t'.
+std::size_t count_blanks(const char *p, std::size_t n) noexcept;
+
+// Comment body: everything up to (excluding) '\n' or '\0'.
+std::size_t count_until_line_end(const char *p, std::size_t n) noexcept;
+
+// Everything up to (excluding) '\n'; unlike count_until_line_end, a
+// '\0' byte does not stop the run.
+std::size_t count_until_newline(const char *p, std::size_t n) noexcept;
+
+// Identifier characters: [A-Za-z0-9_].
+std::size_t count_identifier_chars(const char *p, std::size_t n) noexcept;
+
+[[nodiscard]] ScanIsa active_scan_isa() noexcept;
+
+// Switches the implementation used by the scanners; returns false (and
+// changes nothing) if the CPU does not support the requested one.
+// Meant for tests and benchmarks, not for concurrent use.
+bool force_scan_isa(ScanIsa isa) noexcept;
+
+#endif // FORMAT_SCAN_HPP
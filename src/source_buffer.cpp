@@ -0,0 +1,112 @@
+#include "source_buffer.hpp"
+
+#include <cerrno>
+#include <mutex>
+#include <system_error>
+#include <unordered_set>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+    struct SpellingHash {
+        using is_transparent = void;
+
+        std::size_t operator()(std::string_view s) const noexcept {
+            return std::hash<std::string_view>{}(s);
+        }
+    };
+
+    [[noreturn]] void throw_errno(const std::string &what) {
+        throw std::system_error(errno, std::generic_category(), what);
+    }
+
+    std::string read_all(int fd) {
+        std::string text;
+        std::size_t used = 0;
+        std::size_t capacity = 64 * 1024;
+
+        while (true) {
+            text.resize(capacity);
+            const ssize_t n = ::read(fd, text.data() + used, capacity - used);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("read");
+            }
+            if (n == 0) break;
+            used += static_cast<std::size_t>(n);
+            if (used == capacity) capacity *= 2;
+        }
+
+        text.resize(used);
+        return text;
+    }
+
+    struct FileDescriptor {
+        int fd;
+        ~FileDescriptor() { ::close(fd); }
+    };
+}
+
+// ============================================================
+// Mapped Files
+// ============================================================
+
+struct SourceBuffer::Mapping {
+    void *address;
+    std::size_t length;
+};
+
+void SourceBuffer::Unmap::operator()(Mapping *m) const noexcept {
+    ::munmap(m->address, m->length);
+    delete m;
+}
+
+SourceBuffer::SourceBuffer(std::unique_ptr<Mapping, Unmap> mapping)
+    : m_mapping(std::move(mapping)),
+      m_view(static_cast<const char *>(m_mapping->address), m_mapping->length) {}
+
+SourceBuffer SourceBuffer::from_descriptor(int fd) {
+    struct stat st{};
+    if (::fstat(fd, &st) != 0) throw_errno("fstat");
+
+    // Empty files cannot be mapped; there is nothing to save for them.
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        const auto length = static_cast<std::size_t>(st.st_size);
+        void *address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address != MAP_FAILED) {
+            ::madvise(address, length, MADV_SEQUENTIAL);
+            return SourceBuffer(std::unique_ptr<Mapping, Unmap>(new Mapping{address, length}));
+        }
+    }
+
+    return SourceBuffer(read_all(fd));
+}
+
+SourceBuffer SourceBuffer::from_file(const std::filesystem::path &path) {
+    int fd;
+    do {
+        fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) throw_errno("open " + path.string());
+
+    FileDescriptor guard{fd};
+    return from_descriptor(fd);
+}
+
+// ============================================================
+// Synthesized Spellings
+// ============================================================
+
+std::string_view intern_spelling(std::string_view text) {
+    static std::mutex mutex;
+    static std::unordered_set<std::string, SpellingHash, std::equal_to<>> pool;
+
+    std::lock_guard lock(mutex);
+    auto it = pool.find(text);
+    if (it == pool.end())
+        it = pool.emplace(text).first;
+    return *it;
+}
@@ -0,0 +1,75 @@
+#ifndef FORMAT_SOURCE_BUFFER_HPP
+#define FORMAT_SOURCE_BUFFER_HPP
+
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// ============================================================
+// Source Buffer
+// ============================================================
+//
+// Owns the text of one source file. Token text is a view into this
+// buffer, so the buffer must outlive every Token, UnwrappedLine and
+// CSTNode built from it. The buffer cannot be copied, and moving it
+// keeps the underlying bytes at the same address, so views stay valid
+// across moves of the owner.
+
+class SourceBuffer {
+public:
+    explicit SourceBuffer(std::string text)
+        : m_owned(std::make_unique<const std::string>(std::move(text))), m_view(*m_owned) {}
+
+    // Maps a regular file read-only (with a sequential-access hint), so
+    // the tokenizer reads the page cache directly. Pipes, character
+    // devices and anything else that cannot be mapped are read into
+    // memory instead. Throws std::system_error on I/O errors.
+    static SourceBuffer from_file(const std::filesystem::path &path);
+
+    // Same for an open descriptor, e.g. 0 for piped stdin. The
+    // descriptor is not closed.
+    static SourceBuffer from_descriptor(int fd);
+
+    SourceBuffer(const SourceBuffer &) = delete;
+    SourceBuffer &operator=(const SourceBuffer &) = delete;
+    SourceBuffer(SourceBuffer &&) noexcept = default;
+    SourceBuffer &operator=(SourceBuffer &&) noexcept = default;
+
+    [[nodiscard]] std::string_view view() const noexcept { return m_view; }
+    [[nodiscard]] const char *data() const noexcept { return m_view.data(); }
+    [[nodiscard]] std::size_t size() const noexcept { return m_view.size(); }
+
+    // True if the text is a memory mapping of the file.
+    [[nodiscard]] bool is_mapped() const noexcept { return m_mapping != nullptr; }
+
+    [[nodiscard]] bool owns(std::string_view text) const noexcept {
+        const char *begin = data();
+        return text.data() >= begin && text.data() + text.size() <= begin + size();
+    }
+
+private:
+    struct Mapping;
+    struct Unmap {
+        void operator()(Mapping *m) const noexcept;
+    };
+
+    explicit SourceBuffer(std::unique_ptr<Mapping, Unmap> mapping);
+
+    std::unique_ptr<const std::string> m_owned;
+    std::unique_ptr<Mapping, Unmap> m_mapping;
+    std::string_view m_view;
+};
+
+// ============================================================
+// Synthesized Spellings
+// ============================================================
+//
+// A few tokens have no contiguous spelling in the source, e.g. the
+// signed literal "-3" merged from "- 3". Their text is interned in a
+// process-lifetime pool, so it never dangles and is stored once per
+// distinct spelling. Thread-safe.
+
+std::string_view intern_spelling(std::string_view text);
+
+#endif // FORMAT_SOURCE_BUFFER_HPP
@@ -0,0 +1,78 @@
+#ifndef FORMAT_SPLIT_SCANNER_HPP
+#define FORMAT_SPLIT_SCANNER_HPP
+
+#include <cstddef>
+#include <string_view>
+
+// ============================================================
+// Safe Split Points
+// ============================================================
+//
+// Input may be cut just past a '\n' that ends a logical line: the
+// newline is not inside a string literal and does not follow a '&'
+// continuation. Tokenizing the pieces separately (see the resuming
+// FortranTokenizer constructor) then yields the same tokens as
+// tokenizing the whole input, and no logical line spans two pieces.
+//
+// The scanner mirrors the lexer's view of quotes and comments: a quote
+// outside a comment opens a string that runs to the matching quote,
+// even across newlines, and a '!' outside a string opens a comment.
+
+class SplitScanner {
+public:
+    // Scans the next stretch of input, which must directly follow what
+    // was scanned before. Returns the offset into text just past the
+    // last safe split point in it, or 0 if it contains none.
+    std::size_t scan(std::string_view text) noexcept {
+        std::size_t last = 0;
+
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            const char c = text[i];
+
+            if (m_quote) {
+                if (c == m_quote) m_quote = 0;
+                continue;
+            }
+
+            if (m_comment) {
+                if (c != '\n') continue;
+                m_comment = false;
+            }
+
+            switch (c) {
+                case '\n':
+                    if (!m_continued) last = i + 1;
+                    m_continued = false;
+                    break;
+                case '\'':
+                case '"':
+                    m_quote = c;
+                    m_continued = false;
+                    break;
+                case '!':
+                    // "& ! note" is not a continuation for the line parser
+                    m_comment = true;
+                    m_continued = false;
+                    break;
+                case '&':
+                    m_continued = true;
+                    break;
+                case ' ':
+                case '\t':
+                    break;
+                default:
+                    m_continued = false;
+                    break;
+            }
+        }
+
+        return last;
+    }
+
+private:
+    char m_quote = 0;
+    bool m_comment = false;
+    bool m_continued = false;
+};
+
+#endif // FORMAT_SPLIT_SCANNER_HPP
@@ -0,0 +1,103 @@
+#ifndef FORMAT_STREAMING_TOKENIZER_HPP
+#define FORMAT_STREAMING_TOKENIZER_HPP
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "split_scanner.hpp"
+#include "tokenizer.hpp"
+
+// ============================================================
+// Streaming Tokenizer
+// ============================================================
+//
+// Pull-based tokenizer over chunked input:
+//
+//     StreamingTokenizer st;
+//     while (read(chunk)) {
+//         st.feed(chunk);
+//         for (auto batch = st.next(); !batch.empty(); batch = st.next())
+//             consume(batch);
+//     }
+//     st.finish();
+//     for (auto batch = st.next(); !batch.empty(); batch = st.next())
+//         consume(batch);
+//
+// Each batch holds the tokens of one or more complete logical lines, so
+// tokens, string literals and '&' continuations split across chunks
+// come out exactly as FortranTokenizer would produce them for the whole
+// input. The final batch ends with the EndOfFile token.
+//
+// Token text views the tokenizer's own buffer and stays valid until the
+// next call to feed() or next(). Memory is bounded by the chunk size plus
+// the longest logical line.
+
+class StreamingTokenizer {
+public:
+    explicit StreamingTokenizer(SymbolTable *symbols = nullptr)
+        : m_symbols(symbols) {}
+
+    void feed(std::string_view chunk) {
+        m_buffer.append(chunk);
+    }
+
+    // No more input will follow; the remaining text is released by next().
+    void finish() noexcept {
+        m_finished = true;
+    }
+
+    // Returns the tokens that are complete so far, or an empty span if
+    // more input is needed (or everything has been returned).
+    std::span<const Token> next() {
+        // The previous batch is no longer referenced by the caller.
+        m_buffer.erase(0, m_emitted);
+        m_scanned -= m_emitted;
+        m_emitted = 0;
+        m_batch.clear();
+
+        if (m_done) return {};
+
+        if (std::size_t cut = m_scanner.scan(std::string_view(m_buffer).substr(m_scanned))) {
+            m_cut = m_scanned + cut;
+        }
+        m_scanned = m_buffer.size();
+
+        std::size_t end = m_cut;
+        if (m_finished) {
+            end = m_buffer.size();
+            m_done = true;
+        }
+        if (end == 0 && !m_done) return {};
+
+        FortranTokenizer tz(std::string_view(m_buffer).substr(0, end), m_line, m_symbols);
+        m_batch = tz.tokenize();
+        if (!m_done) {
+            // The piece's EndOfFile sits where the next piece starts.
+            m_line = m_batch.back().line;
+            m_batch.pop_back();
+        }
+
+        m_emitted = end;
+        m_cut = 0;
+        return m_batch;
+    }
+
+    // True once the final batch has been returned.
+    [[nodiscard]] bool done() const noexcept { return m_done; }
+
+private:
+    SymbolTable *m_symbols;
+    SplitScanner m_scanner;
+    std::string m_buffer;
+    std::vector<Token> m_batch;
+    std::size_t m_scanned = 0; // bytes of m_buffer seen by m_scanner
+    std::size_t m_cut = 0;     // end of the complete lines in m_buffer
+    std::size_t m_emitted = 0; // bytes backing the current batch
+    int m_line = 1;
+    bool m_finished = false;
+    bool m_done = false;
+};
+
+#endif // FORMAT_STREAMING_TOKENIZER_HPP
@@ -0,0 +1,60 @@
+#include "symbols.hpp"
+
+namespace {
+    inline unsigned char fold(char c) noexcept {
+        return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c | 0x20) : static_cast<unsigned char>(c);
+    }
+}
+
+std::size_t SymbolTable::FoldedHash::operator()(std::string_view s) const noexcept {
+    uint64_t h = 14695981039346656037ull;
+    for (char c : s) {
+        h ^= fold(c);
+        h *= 1099511628211ull;
+    }
+    return static_cast<std::size_t>(h);
+}
+
+bool SymbolTable::FoldedEqual::operator()(std::string_view a, std::string_view b) const noexcept {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); ++i)
+        if (fold(a[i]) != fold(b[i])) return false;
+    return true;
+}
+
+Symbol SymbolTable::intern(std::string_view name) {
+    if (name.empty()) return {};
+
+    const std::size_t h = FoldedHash{}(name);
+    const uint32_t shard_index = static_cast<uint32_t>(h & (shard_count - 1));
+    Shard &shard = m_shards[shard_index];
+
+    std::lock_guard lock(shard.mutex);
+    if (auto it = shard.index.find(name); it != shard.index.end())
+        return Symbol{it->second};
+
+    std::string &stored = shard.names.emplace_back(name);
+    for (char &c : stored) c = static_cast<char>(fold(c));
+
+    const auto slot = static_cast<uint32_t>(shard.names.size());
+    const uint32_t id = (slot << shard_bits) | shard_index;
+    shard.index.emplace(stored, id);
+    return Symbol{id};
+}
+
+std::string_view SymbolTable::name(Symbol s) const {
+    if (!s) return {};
+
+    const Shard &shard = m_shards[s.id & (shard_count - 1)];
+    std::lock_guard lock(shard.mutex);
+    return shard.names[(s.id >> shard_bits) - 1];
+}
+
+std::size_t SymbolTable::size() const {
+    std::size_t n = 0;
+    for (const auto &shard : m_shards) {
+        std::lock_guard lock(shard.mutex);
+        n += shard.names.size();
+    }
+    return n;
+}
@@ -0,0 +1,70 @@
+#ifndef FORMAT_SYMBOLS_HPP
+#define FORMAT_SYMBOLS_HPP
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// ============================================================
+// Symbol Handles
+// ============================================================
+//
+// An interned, case-folded identifier. Two identifiers interned in the
+// same SymbolTable are equal (Fortran-wise, i.e. ignoring case) iff
+// their symbols compare equal.
+
+struct Symbol {
+    uint32_t id = 0;
+
+    explicit operator bool() const noexcept { return id != 0; }
+    friend bool operator==(Symbol, Symbol) = default;
+};
+
+// ============================================================
+// Symbol Table
+// ============================================================
+//
+// Shared across files (and threads) so that symbols of one project can
+// be compared directly. Lookups of already-known names do not allocate.
+
+class SymbolTable {
+public:
+    SymbolTable() = default;
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    Symbol intern(std::string_view name);
+
+    // The lowercase spelling of a symbol; empty for Symbol{}.
+    [[nodiscard]] std::string_view name(Symbol s) const;
+
+    [[nodiscard]] std::size_t size() const;
+
+private:
+    static constexpr std::size_t shard_bits = 4;
+    static constexpr std::size_t shard_count = std::size_t{1} << shard_bits;
+
+    struct FoldedHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view s) const noexcept;
+    };
+
+    struct FoldedEqual {
+        using is_transparent = void;
+        bool operator()(std::string_view a, std::string_view b) const noexcept;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        std::deque<std::string> names; // stable addresses for the map keys
+        std::unordered_map<std::string_view, uint32_t, FoldedHash, FoldedEqual> index;
+    };
+
+    std::array<Shard, shard_count> m_shards;
+};
+
+#endif // FORMAT_SYMBOLS_HPP
@@ -0,0 +1,158 @@
+#ifndef FORMAT_THREAD_POOL_HPP
+#define FORMAT_THREAD_POOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ============================================================
+// Work-stealing Thread Pool
+// ============================================================
+//
+// A fixed set of workers that run one job at a time. A job is a list of
+// task ids in priority order; the ids are dealt round-robin onto the
+// workers' queues, so every worker starts on the most expensive tasks it
+// was dealt. A worker takes from the front of its own queue and, once it
+// runs dry, steals from the back of the others', where the cheapest
+// tasks wait. Queues are touched once per task, so the short per-queue
+// locks are never contended for long.
+//
+// The calling thread waits in run(); tasks must not call run() again.
+
+class WorkStealingPool {
+public:
+    using Task = std::function<void(unsigned worker, uint32_t task)>;
+
+    explicit WorkStealingPool(unsigned threads = std::thread::hardware_concurrency())
+        : m_queues(std::max(threads, 1u)) {
+        m_workers.reserve(m_queues.size());
+        for (unsigned w = 0; w < m_queues.size(); ++w)
+            m_workers.emplace_back([this, w] { work(w); });
+    }
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    ~WorkStealingPool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wake.notify_all();
+        for (auto &t : m_workers) t.join();
+    }
+
+    [[nodiscard]] unsigned size() const noexcept { return static_cast<unsigned>(m_queues.size()); }
+
+    // Runs task(worker, id) for every id in `order` and returns when all
+    // have finished. The first exception thrown by a task is rethrown
+    // here, after the remaining tasks have run.
+    void run(std::span<const uint32_t> order, const Task &task) {
+        if (order.empty()) return;
+
+        for (std::size_t i = 0; i < order.size(); ++i)
+            m_queues[i % m_queues.size()].tasks.push_back(order[i]);
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_task = &task;
+            m_active = m_workers.size();
+            m_error = nullptr;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        // Once every worker has found all queues empty, all tasks are done
+        // and no worker touches the queues until the next job.
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [&] { return m_active == 0; });
+        m_task = nullptr;
+
+        for (auto &q : m_queues) q.reset();
+        if (m_error) std::rethrow_exception(std::exchange(m_error, nullptr));
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::vector<uint32_t> tasks;
+        std::size_t head = 0; // tasks[head, size) are still queued
+        std::size_t tail = 0; // taken from the back so far
+
+        bool pop_front(uint32_t &out) {
+            std::lock_guard lock(mutex);
+            if (head + tail >= tasks.size()) return false;
+            out = tasks[head++];
+            return true;
+        }
+
+        bool pop_back(uint32_t &out) {
+            std::lock_guard lock(mutex);
+            if (head + tail >= tasks.size()) return false;
+            out = tasks[tasks.size() - ++tail];
+            return true;
+        }
+
+        void reset() {
+            tasks.clear();
+            head = tail = 0;
+        }
+    };
+
+    bool next(unsigned w, uint32_t &out) {
+        if (m_queues[w].pop_front(out)) return true;
+        for (std::size_t i = 1; i < m_queues.size(); ++i)
+            if (m_queues[(w + i) % m_queues.size()].pop_back(out)) return true;
+        return false;
+    }
+
+    void work(unsigned w) {
+        uint64_t seen = 0;
+
+        while (true) {
+            const Task *task;
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stopping || m_generation != seen; });
+                if (m_stopping) return;
+                seen = m_generation;
+                task = m_task;
+            }
+
+            std::exception_ptr error;
+            for (uint32_t id; next(w, id);) {
+                try {
+                    (*task)(w, id);
+                } catch (...) {
+                    if (!error) error = std::current_exception();
+                }
+            }
+
+            std::lock_guard lock(m_mutex);
+            if (error && !m_error) m_error = error;
+            if (--m_active == 0) m_done.notify_all();
+        }
+    }
+
+    std::vector<Queue> m_queues;
+    std::vector<std::thread> m_workers;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    const Task *m_task = nullptr;
+    std::size_t m_active = 0; // workers still taking tasks
+    uint64_t m_generation = 0;
+    std::exception_ptr m_error;
+    bool m_stopping = false;
+};
+
+#endif // FORMAT_THREAD_POOL_HPP
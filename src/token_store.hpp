@@ -0,0 +1,313 @@
+#ifndef FORMAT_TOKEN_STORE_HPP
+#define FORMAT_TOKEN_STORE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "line_index.hpp"
+#include "tokenizer.hpp"
+
+class TokenStore;
+
+// ============================================================
+// Token Span
+// ============================================================
+//
+// A range of tokens in a TokenStore with the query API of Tokens.
+// Elements are materialized as Token values on access; the queries
+// below read only the columns they need.
+
+class TokenSpan {
+public:
+    class iterator {
+    public:
+        // Yields Token values: forward for ranges, input for older code.
+        using iterator_concept = std::forward_iterator_tag;
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using reference = Token;
+        using pointer = void;
+
+        iterator() = default;
+        iterator(const TokenStore *store, uint32_t index) : m_store(store), m_index(index) {}
+
+        Token operator*() const;
+        iterator &operator++() noexcept { ++m_index; return *this; }
+        iterator operator++(int) noexcept { auto it = *this; ++m_index; return it; }
+        bool operator==(const iterator &) const = default;
+
+    private:
+        const TokenStore *m_store = nullptr;
+        uint32_t m_index = 0;
+    };
+
+    TokenSpan() = default;
+    TokenSpan(const TokenStore *store, uint32_t begin, uint32_t end)
+        : m_store(store), m_begin(begin), m_end(end) {}
+
+    [[nodiscard]] iterator begin() const noexcept { return {m_store, m_begin}; }
+    [[nodiscard]] iterator end() const noexcept { return {m_store, m_end}; }
+
+    Token operator[](std::size_t i) const;
+    [[nodiscard]] Token front() const { return (*this)[0]; }
+    [[nodiscard]] Token back() const { return (*this)[size() - 1]; }
+
+    [[nodiscard]] size_t size() const noexcept { return m_end - m_begin; }
+    [[nodiscard]] bool empty() const noexcept { return m_begin == m_end; }
+
+    // Index range in the store.
+    [[nodiscard]] uint32_t first() const noexcept { return m_begin; }
+    [[nodiscard]] uint32_t last() const noexcept { return m_end; }
+
+    [[nodiscard]] std::span<const TokenKind> kinds() const noexcept;
+    [[nodiscard]] std::span<const KeywordId> keywords() const noexcept;
+
+    [[nodiscard]] bool first_token_is(std::string_view text) const noexcept;
+    [[nodiscard]] bool first_token_is(KeywordId id) const noexcept;
+
+    template<typename Range>
+    [[nodiscard]] bool first_token_is_any(const Range &texts) const noexcept {
+        return std::ranges::any_of(texts, [&](const auto &s) { return first_token_is(std::string_view(s)); });
+    }
+
+    [[nodiscard]] bool contains_token(std::string_view text) const noexcept;
+    [[nodiscard]] bool contains_token(KeywordId id) const noexcept;
+    [[nodiscard]] bool contains_kind(TokenKind kind) const noexcept;
+
+    template<typename Range>
+    [[nodiscard]] bool contains_token_sequence(const Range &seq) const noexcept;
+
+private:
+    [[nodiscard]] bool text_is(uint32_t i, std::string_view text) const noexcept;
+
+    const TokenStore *m_store = nullptr;
+    uint32_t m_begin = 0;
+    uint32_t m_end = 0;
+};
+
+// Spans do not own tokens; iterators stay valid while the store lives.
+template<>
+inline constexpr bool std::ranges::enable_borrowed_range<TokenSpan> = true;
+
+// ============================================================
+// Token Store
+// ============================================================
+//
+// Structure-of-arrays token storage: one packed column per field, so a
+// scan over kinds or keyword ids touches one byte per token. Text is
+// kept as a 32-bit offset/length into the source; the rare spellings
+// that are not part of the source (merged signed literals) live in a
+// side table, flagged by the top bit of the length.
+//
+// With TokenPositions::Lazy the line and column columns are not kept:
+// they are answered from the offset through a LineIndex, so positions
+// are physical (see LineIndex). Detached tokens have no offset in the
+// source and keep the position the tokenizer gave them.
+
+enum class TokenPositions : uint8_t {
+    Stored,
+    Lazy
+};
+
+class TokenStore {
+public:
+    explicit TokenStore(std::string_view source, TokenPositions positions = TokenPositions::Stored)
+        : m_source(source), m_positions(positions) {
+        if (source.size() > max_offset)
+            throw std::length_error("TokenStore: source larger than 4 GiB");
+        if (positions == TokenPositions::Lazy)
+            m_index = LineIndex(source);
+    }
+
+    static TokenStore from_source(std::string_view source, SymbolTable *symbols = nullptr,
+                                  TokenPositions positions = TokenPositions::Stored) {
+        TokenStore store(source, positions);
+        store.reserve(source.size() / 4);
+        FortranTokenizer tz(source, symbols);
+        tz.tokenize_into(store);
+        return store;
+    }
+
+    void reserve(std::size_t n) {
+        m_kinds.reserve(n);
+        m_keywords.reserve(n);
+        m_offsets.reserve(n);
+        m_lengths.reserve(n);
+        if (m_positions == TokenPositions::Stored) {
+            m_lines.reserve(n);
+            m_columns.reserve(n);
+        }
+        m_symbols.reserve(n);
+    }
+
+    void push_back(const Token &t) {
+        uint32_t offset = 0;
+        uint32_t length = 0;
+
+        // Empty views into the source (end of file) keep their offset too.
+        const auto *base = m_source.data();
+        if (t.text.data() >= base && t.text.data() + t.text.size() <= base + m_source.size()) {
+            offset = static_cast<uint32_t>(t.text.data() - base);
+            length = static_cast<uint32_t>(t.text.size());
+        } else if (!t.text.empty()) {
+            offset = static_cast<uint32_t>(m_detached.size());
+            length = detached_flag;
+            m_detached.push_back(t.text);
+            if (m_positions == TokenPositions::Lazy)
+                m_detached_positions.push_back({t.line, t.column});
+        }
+
+        m_kinds.push_back(t.kind);
+        m_keywords.push_back(t.keyword);
+        m_offsets.push_back(offset);
+        m_lengths.push_back(length);
+        if (m_positions == TokenPositions::Stored) {
+            m_lines.push_back(t.line);
+            m_columns.push_back(t.column);
+        }
+        m_symbols.push_back(t.symbol);
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return m_kinds.size(); }
+    [[nodiscard]] bool empty() const noexcept { return m_kinds.empty(); }
+    [[nodiscard]] std::string_view source() const noexcept { return m_source; }
+
+    [[nodiscard]] TokenKind kind(std::size_t i) const noexcept { return m_kinds[i]; }
+    [[nodiscard]] KeywordId keyword(std::size_t i) const noexcept { return m_keywords[i]; }
+    [[nodiscard]] TokenPositions positions() const noexcept { return m_positions; }
+
+    [[nodiscard]] SourcePosition position(std::size_t i) const noexcept {
+        if (m_positions == TokenPositions::Stored) return {m_lines[i], m_columns[i]};
+        if (m_lengths[i] & detached_flag) return m_detached_positions[m_offsets[i]];
+        return m_index.position(m_offsets[i]);
+    }
+
+    [[nodiscard]] int line(std::size_t i) const noexcept {
+        if (m_positions == TokenPositions::Stored) return m_lines[i];
+        return position(i).line;
+    }
+
+    [[nodiscard]] int column(std::size_t i) const noexcept {
+        if (m_positions == TokenPositions::Stored) return m_columns[i];
+        return position(i).column;
+    }
+    [[nodiscard]] Symbol symbol(std::size_t i) const noexcept { return m_symbols[i]; }
+
+    [[nodiscard]] std::string_view text(std::size_t i) const noexcept {
+        if (m_lengths[i] & detached_flag) return m_detached[m_offsets[i]];
+        return m_source.substr(m_offsets[i], m_lengths[i]);
+    }
+
+    // Length of the token text, without touching the text itself.
+    [[nodiscard]] std::size_t text_size(std::size_t i) const noexcept {
+        if (m_lengths[i] & detached_flag) return m_detached[m_offsets[i]].size();
+        return m_lengths[i];
+    }
+
+    Token operator[](std::size_t i) const noexcept {
+        const auto at = position(i);
+        return Token{kind(i), text(i), at.line, at.column, keyword(i), symbol(i)};
+    }
+
+    [[nodiscard]] std::span<const TokenKind> kinds() const noexcept { return m_kinds; }
+    [[nodiscard]] std::span<const KeywordId> keywords() const noexcept { return m_keywords; }
+
+    [[nodiscard]] TokenSpan all() const noexcept { return slice(0, size()); }
+
+    [[nodiscard]] TokenSpan slice(std::size_t begin, std::size_t end) const noexcept {
+        return {this, static_cast<uint32_t>(begin), static_cast<uint32_t>(end)};
+    }
+
+private:
+    static constexpr uint32_t detached_flag = uint32_t{1} << 31;
+    static constexpr std::size_t max_offset = UINT32_MAX;
+
+    std::string_view m_source;
+    TokenPositions m_positions;
+    LineIndex m_index; // Lazy only
+    std::vector<TokenKind> m_kinds;
+    std::vector<KeywordId> m_keywords;
+    std::vector<uint32_t> m_offsets;
+    std::vector<uint32_t> m_lengths;
+    std::vector<int> m_lines;
+    std::vector<int> m_columns;
+    std::vector<Symbol> m_symbols;
+    std::vector<std::string_view> m_detached;
+    std::vector<SourcePosition> m_detached_positions; // Lazy only
+};
+
+// ============================================================
+// Token Span (inline definitions)
+// ============================================================
+
+inline Token TokenSpan::iterator::operator*() const { return (*m_store)[m_index]; }
+
+inline Token TokenSpan::operator[](std::size_t i) const { return (*m_store)[m_begin + i]; }
+
+inline std::span<const TokenKind> TokenSpan::kinds() const noexcept {
+    return m_store ? m_store->kinds().subspan(m_begin, size()) : std::span<const TokenKind>{};
+}
+
+inline std::span<const KeywordId> TokenSpan::keywords() const noexcept {
+    return m_store ? m_store->keywords().subspan(m_begin, size()) : std::span<const KeywordId>{};
+}
+
+inline bool TokenSpan::text_is(uint32_t i, std::string_view text) const noexcept {
+    return m_store->text_size(i) == text.size() && m_store->text(i) == text;
+}
+
+inline bool TokenSpan::first_token_is(std::string_view text) const noexcept {
+    return !empty() && text_is(m_begin, text);
+}
+
+inline bool TokenSpan::first_token_is(KeywordId id) const noexcept {
+    return !empty() && m_store->keyword(m_begin) == id;
+}
+
+inline bool TokenSpan::contains_token(std::string_view text) const noexcept {
+    for (uint32_t i = m_begin; i < m_end; ++i)
+        if (text_is(i, text)) return true;
+    return false;
+}
+
+inline bool TokenSpan::contains_token(KeywordId id) const noexcept {
+    return std::ranges::find(keywords(), id) != keywords().end();
+}
+
+inline bool TokenSpan::contains_kind(TokenKind kind) const noexcept {
+    return std::ranges::find(kinds(), kind) != kinds().end();
+}
+
+template<typename Range>
+bool TokenSpan::contains_token_sequence(const Range &seq) const noexcept {
+    const std::size_t n = size();
+    const std::size_t m = std::size(seq);
+
+    if (m == 0 || m > n)
+        return false;
+
+    for (std::size_t i = 0; i <= n - m; ++i) {
+        bool match = true;
+
+        for (std::size_t j = 0; j < m; ++j) {
+            if (!text_is(static_cast<uint32_t>(m_begin + i + j), seq[j])) {
+                match = false;
+                break;
+            }
+        }
+
+        if (match)
+            return true;
+    }
+
+    return false;
+}
+
+#endif // FORMAT_TOKEN_STORE_HPP
@@ -1,9 +1,15 @@
 #pragma once
 #include <string>
 #include <string_view>
+#include <memory_resource>
 #include <vector>
 #include <array>
+#include "keywords.hpp"
 #include "kinds.hpp"
+#include "profile.hpp"
+#include "scan.hpp"
+#include "source_buffer.hpp"
+#include "symbols.hpp"
 #include <algorithm>
 
 // ============================================================
@@ -11,11 +17,17 @@
 // ============================================================
 
 
+// Token text is a view into the tokenized source (or, for synthesized
+// spellings, into the intern pool). Tokens are cheap to copy and never
+// allocate. Keywords carry their KeywordId; identifiers carry a Symbol
+// when the tokenizer was given a SymbolTable.
 struct Token {
     TokenKind kind;
-    std::string text;
+    std::string_view text;
     int line{};
     int column{};
+    KeywordId keyword{KeywordId::Unknown};
+    Symbol symbol{};
 };
 
 // ============================================================
@@ -40,49 +52,171 @@ inline static bool is_space(char c) noexcept {
 }
 
 
+// ============================================================
+// CHARACTER CLASSES
+// ============================================================
+//
+// The first byte of a token decides how it is lexed: one table lookup
+// per token instead of a chain of tests. Bytes that always make a
+// one-character token carry its kind; an operator byte that may begin a
+// two-character operator (">=", "<=", "/=", "==", "**") carries the
+// byte that completes it, so the pair is recognized without a retry.
+
+enum class CharClass : uint8_t {
+    Other,      // a one-byte Unknown token
+    End,        // '\0': end of input
+    Blank,
+    Newline,
+    Bang,       // comment
+    Ampersand,  // continuation
+    Quote,
+    Alpha,
+    Digit,
+    Single,     // one-byte token of `kind`
+    Pair,       // operator, or a two-byte one if followed by `second`
+};
+
+struct CharInfo {
+    CharClass cls = CharClass::Other;
+    TokenKind kind = TokenKind::Unknown;
+    char second = 0;
+};
+
+inline constexpr std::array<CharInfo, 256> char_table = [] {
+    std::array<CharInfo, 256> t{};
+    const auto set = [&](char c, CharClass cls, TokenKind kind = TokenKind::Unknown, char second = 0) {
+        t[static_cast<unsigned char>(c)] = {cls, kind, second};
+    };
+
+    set('\0', CharClass::End);
+    set(' ', CharClass::Blank);
+    set('\t', CharClass::Blank);
+    set('\n', CharClass::Newline);
+    set('!', CharClass::Bang);
+    set('&', CharClass::Ampersand);
+    set('\'', CharClass::Quote);
+    set('"', CharClass::Quote);
+    for (char c = 'a'; c <= 'z'; ++c) set(c, CharClass::Alpha);
+    for (char c = 'A'; c <= 'Z'; ++c) set(c, CharClass::Alpha);
+    for (char c = '0'; c <= '9'; ++c) set(c, CharClass::Digit);
+
+    set(',', CharClass::Single, TokenKind::Comma);
+    set(':', CharClass::Single, TokenKind::Colon);
+    set(';', CharClass::Single, TokenKind::Semicolon);
+    set('(', CharClass::Single, TokenKind::LParen);
+    set(')', CharClass::Single, TokenKind::RParen);
+    set('%', CharClass::Single, TokenKind::Percent);
+    set('+', CharClass::Single, TokenKind::Operator);
+    set('-', CharClass::Single, TokenKind::Operator);
+
+    set('>', CharClass::Pair, TokenKind::Operator, '=');
+    set('<', CharClass::Pair, TokenKind::Operator, '=');
+    set('/', CharClass::Pair, TokenKind::Operator, '=');
+    set('=', CharClass::Pair, TokenKind::Operator, '=');
+    set('*', CharClass::Pair, TokenKind::Operator, '*');
+    return t;
+}();
+
+inline constexpr const CharInfo &char_info(char c) noexcept {
+    return char_table[static_cast<unsigned char>(c)];
+}
+
+
 // ============================================================
 // Fortran Tokenizer
 // ============================================================
 
 class FortranTokenizer {
 public:
-    explicit FortranTokenizer(std::string_view src)
-        : m_source(src), m_pos(0), m_line(1), m_col(1) {}
+    // The caller owns src and must keep it alive while the tokens are used.
+    // With a symbol table, every identifier is interned into it.
+    explicit FortranTokenizer(std::string_view src, SymbolTable *symbols = nullptr)
+        : m_source(src), m_pos(0), m_line(1), m_symbols(symbols) {}
+
+    explicit FortranTokenizer(const SourceBuffer &src, SymbolTable *symbols = nullptr)
+        : FortranTokenizer(src.view(), symbols) {}
+
+    // Tokenizes src as the continuation of a larger input: src must start
+    // a physical line, first_line is its line number, and a first_line
+    // above 1 means the tokens of the preceding lines (ending in a
+    // Newline) have already been produced. The resulting stream is what
+    // tokenizing the whole input would have yielded for these lines.
+    FortranTokenizer(std::string_view src, int first_line, SymbolTable *symbols = nullptr)
+        : m_source(src), m_pos(0), m_line(first_line), m_symbols(symbols),
+          m_resumed(first_line > 1) {}
+
+    // Tokens would dangle once a temporary buffer is destroyed.
+    explicit FortranTokenizer(const SourceBuffer &&, SymbolTable * = nullptr) = delete;
 
     [[nodiscard]] std::vector<Token> tokenize() {
+        FORMAT_PROFILE_SCOPE("tokenize", "tokens");
         std::vector<Token> out;
         out.reserve(m_source.size() / 4);
+        tokenize_into(out);
+        FORMAT_PROFILE_ITEMS(out.size());
+        return out;
+    }
+
+    // Same, with the vector allocated from `resource` (e.g. a FileArena).
+    [[nodiscard]] std::pmr::vector<Token> tokenize(std::pmr::memory_resource *resource) {
+        FORMAT_PROFILE_SCOPE("tokenize", "tokens");
+        std::pmr::vector<Token> out(resource);
+        out.reserve(m_source.size() / 4);
+        tokenize_into(out);
+        FORMAT_PROFILE_ITEMS(out.size());
+        return out;
+    }
+
+    // Appends the tokens to any container with push_back(const Token&),
+    // e.g. a TokenStore.
+    template<typename Out>
+    void tokenize_into(Out &out) {
+        // A lone "+"/"-" is held back one token: if a number follows, both
+        // are emitted as one signed literal.
+        Token sign{};
+        bool holding_sign = false;
 
         while (true) {
             Token t = next_token();
 
-            if (t.kind != TokenKind::Whitespace) {
-                if (is_unary_sign_merge(out, t)) {
-                    Token& sign = out.back();  // "+" or "-"
+            if (t.kind == TokenKind::Whitespace)
+                continue;
+
+            if (holding_sign) {
+                holding_sign = false;
 
+                if (t.kind == TokenKind::Number) {
+                    const std::string_view extent(sign.text.data(),
+                        static_cast<size_t>(t.text.data() + t.text.size() - sign.text.data()));
                     sign.kind = TokenKind::Number;
-                    sign.text.reserve(sign.text.size() + t.text.size());
-                    sign.text += t.text;       // merge "+1"
-                } else {
-                    out.push_back(std::move(t));
+                    sign.text = merge_spelling(sign.text, t.text); // merge "+1"
+                    emit(out, sign, extent);
+                    continue;
                 }
+                emit(out, sign, sign.text);
             }
 
-            m_prev_kind = t.kind;
-            m_tokens_empty = false;
+            if (may_start_signed_literal(t)) {
+                sign = t;
+                holding_sign = true;
+                continue;
+            }
+
+            emit(out, t, t.text);
 
             if (t.kind == TokenKind::EndOfFile)
                 break;
         }
-
-        return out;
     }
 
 private:
     std::string_view m_source;
     size_t m_pos;
-    int m_line, m_col;
-    TokenKind m_prev_kind = TokenKind::Unknown;
+    int m_line;
+    size_t m_line_start = 0; // columns are counted from here, not byte by byte
+    SymbolTable *m_symbols;
+    bool m_resumed = false;
+    TokenKind m_prev_kind = TokenKind::Unknown; // last emitted token
     bool m_tokens_empty = true;
 
     // ============================================================
@@ -95,15 +229,36 @@ private:
 
     char get() noexcept {
         char c = peek();
-        if (c != '\0') {
-            ++m_pos;
-            ++m_col;
-        }
+        if (c != '\0') ++m_pos;
         return c;
     }
 
+    // Skips a run of n bytes that contains no newline.
+    void advance(size_t n) noexcept {
+        m_pos += n;
+    }
+
+    [[nodiscard]] int column() const noexcept {
+        return static_cast<int>(m_pos - m_line_start) + 1;
+    }
+
+    [[nodiscard]] const char *cursor() const noexcept { return m_source.data() + m_pos; }
+    [[nodiscard]] size_t remaining() const noexcept { return m_source.size() - m_pos; }
+
     Token make(TokenKind k, int line, int col, size_t start, size_t len) const {
-        return Token{k, std::string(m_source.data() + start, len), line, col};
+        return Token{k, m_source.substr(start, len), line, col};
+    }
+
+    // "-1" is contiguous in the source and stays a view; "- 1" is not,
+    // so its spelling is interned.
+    static std::string_view merge_spelling(std::string_view sign, std::string_view number) {
+        if (sign.data() + sign.size() == number.data())
+            return {sign.data(), sign.size() + number.size()};
+
+        std::string merged;
+        merged.reserve(sign.size() + number.size());
+        merged.append(sign).append(number);
+        return intern_spelling(merged);
     }
 
 
@@ -111,28 +266,36 @@ private:
     // UNARY SIGN MERGE LOGIC
     // ============================================================
 
-    inline static bool is_unary_sign_merge(
-        const std::vector<Token>& toks,
-        const Token& current)
-    {
-        if (current.kind != TokenKind::Number)
-            return false;
-
-        if (toks.size() < 2)
-            return false;
-
-        const Token& sign = toks[toks.size() - 1];
-        const Token& prev = toks[toks.size() - 2];
+    // `extent` is the source the token was lexed from: its text, except
+    // for a merged "- 1". Sinks that store offsets rather than views
+    // (PackedTokens) take it as a second argument.
+    template<typename Out>
+    void emit(Out &out, const Token &t, std::string_view extent) {
+        if constexpr (requires { out.push_back(t, extent); })
+            out.push_back(t, extent);
+        else
+            out.push_back(t);
+        m_prev_kind = t.kind;
+        m_tokens_empty = false;
+    }
 
+    [[nodiscard]] bool may_start_signed_literal(const Token &t) const noexcept {
         bool sign_ok =
-            sign.kind == TokenKind::Operator &&
-            sign.text.size() == 1 &&
-            (sign.text[0] == '+' || sign.text[0] == '-');
+            t.kind == TokenKind::Operator &&
+            t.text.size() == 1 &&
+            (t.text[0] == '+' || t.text[0] == '-');
 
         if (!sign_ok) return false;
 
-        // avoid merging 1 - -1 → incorrect
-        if (prev.kind == TokenKind::Number || prev.kind == TokenKind::Identifier)
+        // the sign opens this piece; what precedes it is the Newline that
+        // ended the previous piece
+        if (m_tokens_empty)
+            return m_resumed;
+
+        // after an operand the sign is a binary operator: "1 - 1",
+        // "n - 1", "f(x) - 1"
+        if (m_prev_kind == TokenKind::Number || m_prev_kind == TokenKind::Identifier ||
+            m_prev_kind == TokenKind::RParen)
             return false;
 
         return true;
@@ -145,26 +308,22 @@ private:
 
     Token next_token() {
         int line = m_line;
-        int col  = m_col;
-        char c   = peek();
-
-        if (c == '\0')
-            return {TokenKind::EndOfFile, "", line, col};
-
-        if (is_space(c))    return lex_whitespace(line, col);
-        if (c == '\n')      return lex_newline(line, col);
-        if (c == '!')       return lex_comment(line, col);
-        if (c == '&')       return lex_continuation(line, col);
-        if (c == '\'' || c == '"') return lex_string_literal(line, col);
-        if (is_alpha(c))    return lex_identifier_or_keyword(line, col);
-        if (is_digit(c))    return lex_number(line, col);
-
-        if (auto t = lex_punctuation(line, col); t.kind != TokenKind::Unknown)
-            return t;
-
-        if (auto t = lex_operator(line, col); t.kind != TokenKind::Unknown)
-            return t;
-
+        int col  = column();
+        const CharInfo &info = char_info(peek());
+
+        switch (info.cls) {
+            case CharClass::End:       return make(TokenKind::EndOfFile, line, col, m_pos, 0);
+            case CharClass::Blank:     return lex_whitespace(line, col);
+            case CharClass::Newline:   return lex_newline(line, col);
+            case CharClass::Bang:      return lex_comment(line, col);
+            case CharClass::Ampersand: return lex_continuation(line, col);
+            case CharClass::Quote:     return lex_string_literal(line, col);
+            case CharClass::Alpha:     return lex_identifier_or_keyword(line, col);
+            case CharClass::Digit:     return lex_number(line, col);
+            case CharClass::Single:    return lex_single(info.kind, line, col);
+            case CharClass::Pair:      return lex_pair(info.second, line, col);
+            case CharClass::Other:     break;
+        }
         return lex_unknown(line, col);
     }
 
@@ -175,25 +334,28 @@ private:
 
     Token lex_whitespace(int line, int col) {
         size_t start = m_pos;
-        while (is_space(peek())) get();
+        advance(count_blanks(cursor(), remaining()));
         return make(TokenKind::Whitespace, line, col, start, m_pos - start);
     }
 
     Token lex_newline(int line, int col) {
+        size_t start = m_pos;
         get();
-        ++m_line; m_col = 1;
-        return {TokenKind::Newline, "\n", line, col};
+        ++m_line;
+        m_line_start = m_pos;
+        return make(TokenKind::Newline, line, col, start, 1);
     }
 
     Token lex_comment(int line, int col) {
         size_t start = m_pos;
-        while (peek() != '\n' && peek() != '\0') get();
+        advance(count_until_line_end(cursor(), remaining()));
         return make(TokenKind::Comment, line, col, start, m_pos - start);
     }
 
     Token lex_continuation(int line, int col) {
+        size_t start = m_pos;
         get();
-        return {TokenKind::Continuation, "&", line, col};
+        return make(TokenKind::Continuation, line, col, start, 1);
     }
 
     Token lex_string_literal(int line, int col) {
@@ -209,16 +371,16 @@ private:
 
     Token lex_identifier_or_keyword(int line, int col) {
         size_t start = m_pos;
-
-        while (is_alnum_or_underscore(peek()))
-            get();
+        advance(count_identifier_chars(cursor(), remaining()));
 
         std::string_view v(m_source.data() + start, m_pos - start);
 
-        if (is_keyword(v))
-            return {TokenKind::Keyword, std::string(v), line, col};
+        if (KeywordId id = lookup_keyword(v); id != KeywordId::Unknown)
+            return {TokenKind::Keyword, v, line, col, id};
 
-        return {TokenKind::Identifier, std::string(v), line, col};
+        Token t{TokenKind::Identifier, v, line, col};
+        if (m_symbols) t.symbol = m_symbols->intern(v);
+        return t;
     }
 
     Token lex_number(int line, int col) {
@@ -246,71 +408,24 @@ private:
         return make(TokenKind::Number, line, col, start, m_pos - start);
     }
 
-    Token lex_punctuation(int line, int col) {
-        char c = peek();
-        switch (c) {
-            case ',': get(); return {TokenKind::Comma, ",", line, col};
-            case ':': get(); return {TokenKind::Colon, ":", line, col};
-            case ';': get(); return {TokenKind::Semicolon, ";", line, col};
-            case '(': get(); return {TokenKind::LParen, "(", line, col};
-            case ')': get(); return {TokenKind::RParen, ")", line, col};
-            case '%': get(); return {TokenKind::Percent, "%", line, col};
-        }
-        return {TokenKind::Unknown, "", line, col};
+    // Punctuation and the operators that never pair.
+    Token lex_single(TokenKind kind, int line, int col) {
+        size_t start = m_pos;
+        advance(1);
+        return make(kind, line, col, start, 1);
     }
 
-    Token lex_operator(int line, int col) {
-        static constexpr std::array two_ops{
-            ">=", "<=", "/=", "==", "**"
-        };
-
-        if (m_pos + 1 < m_source.size()) {
-            std::string_view two(m_source.data() + m_pos, 2);
-            for (auto op : two_ops) {
-                if (two == op) {
-                    m_pos += 2;
-                    m_col += 2;
-                    return {TokenKind::Operator, std::string(op), line, col};
-                }
-            }
-        }
-
-        char c = peek();
-        if (c == '+' || c == '-' || c == '*' || c == '/' ||
-            c == '=' || c == '<' || c == '>') {
-            get();
-            return {TokenKind::Operator, std::string(1, c), line, col};
-        }
-
-        return {TokenKind::Unknown, "", line, col};
+    // An operator, two bytes long if the next byte is `second`.
+    Token lex_pair(char second, int line, int col) {
+        size_t start = m_pos;
+        const size_t len = remaining() > 1 && m_source[m_pos + 1] == second ? 2 : 1;
+        advance(len);
+        return make(TokenKind::Operator, line, col, start, len);
     }
 
     Token lex_unknown(int line, int col) {
-        char c = get();
-        return {TokenKind::Unknown, std::string(1, c), line, col};
-    }
-
-
-    // ============================================================
-    // Keyword Matcher
-    // ============================================================
-
-    static bool is_keyword(std::string_view s) noexcept {
-        static constexpr std::array keywords{
-            "program","end","contains","module","end module","abstract",
-            "abstract interface","interface","end interface","subroutine",
-            "end subroutine","call","function","end function","select",
-            "select case","end select","case","do","enddo","end do","if",
-            "then","else","else if","endif","end if","use","print","implicit",
-            "none","integer","real","double","precision","logical", "recursive",
-            "type", "pure"
-        };
-
-        std::string lower;
-        lower.reserve(s.size());
-        for (char c : s) lower.push_back(std::tolower((unsigned char)c));
-
-        return std::find(keywords.begin(), keywords.end(),
-                         std::string_view(lower)) != keywords.end();
+        size_t start = m_pos;
+        get();
+        return make(TokenKind::Unknown, line, col, start, 1);
     }
 };
@@ -1,13 +1,15 @@
 #ifndef FORMAT_TOKENS_HPP
 #define FORMAT_TOKENS_HPP
 #include "tokenizer.hpp"
+#include <memory_resource>
 #include <ranges>
 
 class Tokens {
-    std::vector<Token> m_data;
+    std::pmr::vector<Token> m_data;
 
 public:
     Tokens() = default;
+    explicit Tokens(std::pmr::memory_resource *resource) : m_data(resource) {}
     void push_back(const Token &token) noexcept {
         m_data.push_back(token);
     }
@@ -34,10 +36,17 @@ public:
     [[nodiscard]] size_t size() const noexcept { return m_data.size(); }
     [[nodiscard]] bool empty() const noexcept { return m_data.empty(); }
 
-    [[nodiscard]] bool first_token_is(const std::string &text) const noexcept {
+    // Keeps the capacity, for reuse by the next line.
+    void clear() noexcept { m_data.clear(); }
+
+    [[nodiscard]] bool first_token_is(std::string_view text) const noexcept {
         return !m_data.empty() && m_data[0].text == text;
     }
 
+    [[nodiscard]] bool first_token_is(KeywordId id) const noexcept {
+        return !m_data.empty() && m_data[0].keyword == id;
+    }
+
     template<typename Range>
     [[nodiscard]] bool first_token_is_any(const Range &texts) const noexcept {
         if (m_data.empty()) return false;
@@ -49,13 +58,19 @@ public:
         });
     }
 
-    [[nodiscard]] bool contains_token(const std::string &text) const noexcept {
+    [[nodiscard]] bool contains_token(std::string_view text) const noexcept {
         return std::ranges::any_of(m_data, [&](const auto &s) {
             if (s.text == text) return true;
             return false;
         });
     }
 
+    [[nodiscard]] bool contains_token(KeywordId id) const noexcept {
+        return std::ranges::any_of(m_data, [&](const auto &s) {
+            return s.keyword == id;
+        });
+    }
+
     template<typename Range>
     [[nodiscard]] bool contains_token_sequence(const Range &seq) const noexcept {
         const std::size_t n = m_data.size();
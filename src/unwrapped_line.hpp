@@ -2,7 +2,15 @@
 #define FORMAT_UNWRAPPED_LINE_HPP
 
 #include "tokenizer.hpp"
+#include "profile.hpp"
 #include "tokens.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <utility>
 #include <vector>
 #include <ranges>
 
@@ -11,58 +19,340 @@ struct UnwrappedLine {
     Tokens tokens;
 };
 
-class UnwrappedLineParser {
+// ============================================================
+// Index-range Lines
+// ============================================================
+//
+// A logical line as a range of indices into the tokenizer output,
+// [begin, end), minus the tokens the parser drops inside it (the Newline
+// after a '&' continuation, whitespace). The dropped indices are kept,
+// sorted, in the LineTable's splice list.
+
+struct LineRange {
+    uint32_t begin = 0;
+    uint32_t end = 0;
+    uint32_t splice_begin = 0; // range in LineTable::splices()
+    uint32_t splice_end = 0;
+};
+
+// The tokens of one range line, with the Tokens query API. Source is
+// what the tokens are read from: a span of Tokens, or any handle with
+// size() and operator[] (e.g. PackedTokenView, whose elements are
+// materialized as Token values).
+template<typename Source>
+class BasicLineTokens {
 public:
-    explicit UnwrappedLineParser(const std::vector<Token> &tokens)
+    using reference = decltype(std::declval<const Source &>()[std::size_t{}]);
+
+    class iterator {
+    public:
+        using iterator_concept = std::forward_iterator_tag;
+        // Sources that yield Token values are input-only to pre-ranges code.
+        using iterator_category = std::conditional_t<std::is_lvalue_reference_v<BasicLineTokens::reference>,
+                                                     std::forward_iterator_tag, std::input_iterator_tag>;
+        using value_type = Token;
+        using difference_type = std::ptrdiff_t;
+        using reference = BasicLineTokens::reference;
+
+        iterator() = default;
+        iterator(Source tokens, uint32_t index, const uint32_t *splice, const uint32_t *splice_end)
+            : m_tokens(tokens), m_index(index), m_splice(splice), m_splice_end(splice_end) {
+            skip();
+        }
+
+        reference operator*() const noexcept { return m_tokens[m_index]; }
+        const Token *operator->() const noexcept
+            requires std::is_lvalue_reference_v<reference> { return &m_tokens[m_index]; }
+        iterator &operator++() noexcept { ++m_index; skip(); return *this; }
+        iterator operator++(int) noexcept { auto it = *this; ++*this; return it; }
+        bool operator==(const iterator &o) const noexcept { return m_index == o.m_index; }
+
+    private:
+        void skip() noexcept {
+            while (m_splice != m_splice_end && *m_splice == m_index) {
+                ++m_index;
+                ++m_splice;
+            }
+        }
+
+        Source m_tokens{};
+        uint32_t m_index = 0;
+        const uint32_t *m_splice = nullptr;
+        const uint32_t *m_splice_end = nullptr;
+    };
+
+    BasicLineTokens() = default;
+    BasicLineTokens(Source tokens, LineRange range, std::span<const uint32_t> splices)
+        : m_tokens(tokens), m_range(range), m_splices(splices) {}
+
+    [[nodiscard]] iterator begin() const noexcept {
+        return {m_tokens, m_range.begin, m_splices.data(), m_splices.data() + m_splices.size()};
+    }
+    [[nodiscard]] iterator end() const noexcept {
+        return {m_tokens, m_range.end, nullptr, nullptr};
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return m_range.end - m_range.begin - m_splices.size(); }
+    [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+    // O(number of splices in the line), which is almost always zero.
+    reference operator[](std::size_t i) const noexcept {
+        auto index = static_cast<uint32_t>(m_range.begin + i);
+        for (uint32_t s : m_splices) {
+            if (s > index) break;
+            ++index;
+        }
+        return m_tokens[index];
+    }
+
+    [[nodiscard]] reference front() const noexcept { return (*this)[0]; }
+    [[nodiscard]] reference back() const noexcept { return (*this)[size() - 1]; }
+
+    [[nodiscard]] LineRange range() const noexcept { return m_range; }
+
+    [[nodiscard]] bool first_token_is(std::string_view text) const noexcept {
+        return !empty() && front().text == text;
+    }
+
+    [[nodiscard]] bool first_token_is(KeywordId id) const noexcept {
+        return !empty() && front().keyword == id;
+    }
+
+    template<typename Range>
+    [[nodiscard]] bool first_token_is_any(const Range &texts) const noexcept {
+        if (empty()) return false;
+        const std::string_view first = front().text;
+        return std::ranges::any_of(texts, [&](const auto &s) { return first == s; });
+    }
+
+    [[nodiscard]] bool contains_token(std::string_view text) const noexcept {
+        return std::ranges::any_of(*this, [&](const Token &t) { return t.text == text; });
+    }
+
+    [[nodiscard]] bool contains_token(KeywordId id) const noexcept {
+        return std::ranges::any_of(*this, [&](const Token &t) { return t.keyword == id; });
+    }
+
+    template<typename Range>
+    [[nodiscard]] bool contains_token_sequence(const Range &seq) const noexcept {
+        const std::size_t n = size();
+        const std::size_t m = std::size(seq);
+
+        if (m == 0 || m > n)
+            return false;
+
+        for (std::size_t i = 0; i <= n - m; ++i) {
+            bool match = true;
+
+            for (std::size_t j = 0; j < m; ++j) {
+                if ((*this)[i + j].text != seq[j]) {
+                    match = false;
+                    break;
+                }
+            }
+
+            if (match)
+                return true;
+        }
+
+        return false;
+    }
+
+private:
+    Source m_tokens{};
+    LineRange m_range{};
+    std::span<const uint32_t> m_splices;
+};
+
+template<typename Source>
+inline constexpr bool std::ranges::enable_borrowed_range<BasicLineTokens<Source>> = true;
+
+// Drop-in for UnwrappedLine where a range line is used.
+template<typename Source>
+struct BasicLineView {
+    BasicLineTokens<Source> tokens;
+};
+
+// All logical lines of a token stream. Views into the tokens, which must
+// outlive the table.
+template<typename Source>
+class BasicLineTable {
+public:
+    BasicLineTable() = default;
+    explicit BasicLineTable(Source tokens,
+                            std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : m_tokens(tokens), m_lines(resource), m_splices(resource) {}
+
+    [[nodiscard]] size_t size() const noexcept { return m_lines.size(); }
+    [[nodiscard]] bool empty() const noexcept { return m_lines.empty(); }
+
+    BasicLineView<Source> operator[](std::size_t i) const noexcept {
+        const LineRange &r = m_lines[i];
+        return {BasicLineTokens<Source>(m_tokens, r, std::span(m_splices).subspan(r.splice_begin, r.splice_end - r.splice_begin))};
+    }
+
+    [[nodiscard]] std::span<const LineRange> ranges() const noexcept { return m_lines; }
+    [[nodiscard]] std::span<const uint32_t> splices() const noexcept { return m_splices; }
+    [[nodiscard]] Source tokens() const noexcept { return m_tokens; }
+
+    // Building interface, used by UnwrappedLineParser. Indices must
+    // increase from call to call.
+    void open_line(uint32_t begin) {
+        const auto s = static_cast<uint32_t>(m_splices.size());
+        m_lines.push_back({begin, begin, s, s});
+    }
+
+    // Makes tokens up to `end` part of the current line, including the
+    // splices recorded before it. Splices that no token follows (trailing
+    // whitespace) are never committed.
+    void extend_to(uint32_t end) noexcept {
+        m_lines.back().end = end;
+        m_lines.back().splice_end = static_cast<uint32_t>(m_splices.size());
+    }
+
+    // Drops token `index` from the current line.
+    void splice(uint32_t index) {
+        m_splices.push_back(index);
+    }
+
+    void reserve(std::size_t lines) { m_lines.reserve(lines); }
+
+private:
+    Source m_tokens{};
+    std::pmr::vector<LineRange> m_lines;
+    std::pmr::vector<uint32_t> m_splices;
+};
+
+using LineTokens = BasicLineTokens<std::span<const Token>>;
+using UnwrappedLineView = BasicLineView<std::span<const Token>>;
+using LineTable = BasicLineTable<std::span<const Token>>;
+
+template<typename Source>
+class BasicUnwrappedLineParser {
+public:
+    explicit BasicUnwrappedLineParser(Source tokens)
         : m_tokens(tokens) {
     }
 
     [[nodiscard]] std::vector<UnwrappedLine> parse() const {
+        FORMAT_PROFILE_SCOPE("parse", "lines");
         std::vector<UnwrappedLine> lines;
-        lines.emplace_back();
+        parse_into(lines, std::pmr::get_default_resource());
+        FORMAT_PROFILE_ITEMS(lines.size());
+        return lines;
+    }
+
+    // Same, with the lines and their tokens allocated from `resource`.
+    [[nodiscard]] std::pmr::vector<UnwrappedLine> parse(std::pmr::memory_resource *resource) const {
+        FORMAT_PROFILE_SCOPE("parse", "lines");
+        std::pmr::vector<UnwrappedLine> lines(resource);
+        lines.reserve(m_tokens.size() / 8 + 1);
+        parse_into(lines, resource);
+        FORMAT_PROFILE_ITEMS(lines.size());
+        return lines;
+    }
+
+    // The same lines as parse(), as index ranges into the tokens: no
+    // token is copied, and only token kinds are read. The table views
+    // the parser's tokens.
+    [[nodiscard]] BasicLineTable<Source> parse_ranges(
+        std::pmr::memory_resource *resource = std::pmr::get_default_resource()) const {
+        FORMAT_PROFILE_SCOPE("parse", "lines");
+        BasicLineTable<Source> table(m_tokens, resource);
+        table.open_line(0);
 
         const std::size_t num_tokens = m_tokens.size();
-        if (num_tokens == 0) return lines;
+        if (num_tokens == 0) return table;
         if (num_tokens == 1) {
-            lines.back().tokens.push_back(m_tokens[0]);
-            return lines;
+            table.extend_to(1);
+            return table;
+        }
+
+        table.reserve(num_tokens / 8);
+
+        bool skip_next_newline = false;
+
+        // As in parse(), the last token (EndOfFile) is never part of a line.
+        for (uint32_t i = 0; i + 1 < num_tokens; ++i) {
+            const TokenKind cur = kind(i);
+
+            if (skip_next_newline && cur == TokenKind::Newline) {
+                skip_next_newline = false;
+                table.splice(i);
+                continue;
+            }
+
+            if (cur == TokenKind::Continuation && kind(i + 1) == TokenKind::Newline) {
+                table.extend_to(i + 1);
+                skip_next_newline = true;
+                continue;
+            }
+
+            if (cur == TokenKind::Whitespace) {
+                table.splice(i);
+                continue;
+            }
+
+            table.extend_to(i + 1);
+
+            if (cur == TokenKind::Newline) {
+                table.open_line(i + 1);
+            }
         }
+        FORMAT_PROFILE_ITEMS(table.size());
+        return table;
+    }
 
+private:
+    template<typename Lines>
+    void parse_into(Lines &lines, std::pmr::memory_resource *resource) const {
+        lines.push_back(UnwrappedLine{Tokens(resource)});
 
-        auto head = m_tokens | std::views::take(num_tokens - 1);
-        auto tail = m_tokens | std::views::drop(1);
+        const std::size_t num_tokens = m_tokens.size();
+        if (num_tokens == 0) return;
+        if (num_tokens == 1) {
+            lines.back().tokens.push_back(m_tokens[0]);
+            return;
+        }
 
         bool skip_next_newline = false;
 
-        for (auto [cur, next]: std::views::zip(head, tail)) {
+        // The last token (EndOfFile) is only ever looked at as `next`.
+        for (std::size_t i = 0; i + 1 < num_tokens; ++i) {
+            const TokenKind cur = kind(i);
+
             if (skip_next_newline) {
-                if (cur.kind == TokenKind::Newline) {
+                if (cur == TokenKind::Newline) {
                     skip_next_newline = false;
                     continue;
                 }
             }
 
-            if (is_continuation_pair(cur, next)) {
-                lines.back().tokens.push_back(cur);
+            if (cur == TokenKind::Continuation && kind(i + 1) == TokenKind::Newline) {
+                lines.back().tokens.push_back(m_tokens[i]);
                 skip_next_newline = true;
                 continue;
             }
-            if (cur.kind != TokenKind::Whitespace) lines.back().tokens.push_back(cur);
+            if (cur != TokenKind::Whitespace) lines.back().tokens.push_back(m_tokens[i]);
 
-            if (cur.kind == TokenKind::Newline) {
-                lines.emplace_back();
+            if (cur == TokenKind::Newline) {
+                lines.push_back(UnwrappedLine{Tokens(resource)});
             }
         }
-        return lines;
     }
 
-private:
-    [[nodiscard]] static bool is_continuation_pair(const Token &a, const Token &b) noexcept {
-        return a.kind == TokenKind::Continuation && b.kind == TokenKind::Newline;
+    // Sources with a kind column are read without materializing tokens.
+    [[nodiscard]] TokenKind kind(std::size_t i) const noexcept {
+        if constexpr (requires { m_tokens.kind(i); })
+            return m_tokens.kind(i);
+        else
+            return m_tokens[i].kind;
     }
 
 private:
-    const std::vector<Token> &m_tokens;
+    Source m_tokens;
 };
 
+using UnwrappedLineParser = BasicUnwrappedLineParser<std::span<const Token>>;
+
 #endif // FORMAT_UNWRAPPED_LINE_HPP
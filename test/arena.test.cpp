@@ -0,0 +1,159 @@
+#include <ut.hpp>
+#include "arena.hpp"
+#include "cst.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+#ifdef FORMAT_ENABLE_PROFILING
+// Profiling builds already count allocations, per thread.
+static std::size_t allocations() { return thread_alloc_counts().allocations; }
+#else
+// Counts heap allocations made through the global operator new.
+static std::atomic<std::size_t> g_allocations{0};
+
+void *operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+static std::size_t allocations() { return g_allocations.load(); }
+#endif
+
+namespace {
+    const std::string source =
+        "program p\n"
+        "  implicit none\n"
+        "  integer :: i, &\n"
+        "      j\n"
+        "contains\n"
+        "  subroutine s()\n"
+        "    if (i > 0) then\n"
+        "      do i = 1, 10\n"
+        "        call f(i, j) ! note\n"
+        "      end do\n"
+        "    end if\n"
+        "  end subroutine s\n"
+        "end program p\n";
+
+    struct Result {
+        std::size_t nodes;
+        std::size_t blocks;
+        NodeKind first_child;
+    };
+
+    Result run_pipeline(FileArena &arena) {
+        arena.reset(FileArena::estimate(source.size()));
+
+        FortranTokenizer tz(source);
+        const auto tokens = tz.tokenize(arena.resource());
+        const auto lines = UnwrappedLineParser(tokens).parse(arena.resource());
+        BlockTreeBuilder tree(arena.resource());
+        const auto cst = build_cst(lines, &tree, arena.resource());
+
+        return {cst.size(), tree.root->children.size(), tree.root->children.at(0)->begin_node->kind};
+    }
+}
+
+int main() {
+    "arena pipeline matches the heap pipeline"_test = [] {
+        given("A file processed with and without an arena") = [] {
+            FileArena arena;
+            const Result arena_result = run_pipeline(arena);
+
+            FortranTokenizer tz(source);
+            const auto tokens = tz.tokenize();
+            const auto lines = UnwrappedLineParser(tokens).parse();
+            BlockTreeBuilder tree;
+            const auto cst = build_cst(lines, &tree);
+
+            then("Both build the same CST and block tree.") = [&] {
+                expect(arena_result.nodes == cst.size());
+                expect(arena_result.blocks == tree.root->children.size());
+                expect(arena_result.first_child == NodeKind::Subroutine);
+            };
+        };
+    };
+
+    "arena pipeline does not touch the heap"_test = [] {
+        given("A warmed-up arena") = [] {
+            FileArena arena;
+            run_pipeline(arena);
+
+            when("The same file is processed again") = [&] {
+                const std::size_t before = allocations();
+                const Result result = run_pipeline(arena);
+                const std::size_t after = allocations();
+
+                then("No allocation reaches operator new.") = [&] {
+                    expect(after - before == 0_ul);
+                    expect(result.nodes > 0_ul);
+                    expect(arena.spilled() == 0_ul);
+                };
+            };
+        };
+    };
+
+    "arena grows to cover spills"_test = [] {
+        given("An arena smaller than one file needs") = [] {
+            FileArena arena(64);
+            const std::string big(4096, '\n');
+            {
+                const auto tokens = FortranTokenizer(big).tokenize(arena.resource());
+                expect(tokens.size() == 4097_ul);
+            }
+            const std::size_t spilled = arena.spilled();
+
+            when("It is reset") = [&] {
+                arena.reset();
+
+                then("The block covers what was spilled.") = [&] {
+                    expect(spilled > 0_ul);
+                    expect(arena.capacity() >= 64 + spilled);
+                    expect(arena.spilled() == 0_ul);
+                };
+            };
+        };
+    };
+
+    "arena gives back a block grown past its retain limit"_test = [] {
+        given("An arena that may keep 1 MB") = [] {
+            FileArena arena(64 << 10, 1 << 20);
+
+            when("One file needs much more, and the next does not") = [&] {
+                arena.reset(FileArena::estimate(8 << 20));
+                const std::size_t big = arena.capacity();
+                arena.reset(FileArena::estimate(1 << 10));
+
+                then("The block shrinks back to the limit.") = [&] {
+                    expect(big >= FileArena::estimate(8 << 20));
+                    expect(arena.capacity() == std::size_t{1} << 20);
+                };
+            };
+
+            when("Files spill without asking for a size") = [&] {
+                arena.reset(64 << 10);
+                const std::string big(200000, '\n');
+                {
+                    const auto tokens = FortranTokenizer(big).tokenize(arena.resource());
+                    expect(tokens.size() == 200001_ul);
+                }
+                arena.reset();
+
+                then("Growth from spills stops at the limit.") = [&] {
+                    expect(arena.capacity() <= std::size_t{1} << 20);
+                };
+            };
+        };
+    };
+}
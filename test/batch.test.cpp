@@ -0,0 +1,137 @@
+#include <ut.hpp>
+#include "batch.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct TempDir {
+        fs::path path;
+
+        TempDir() : path(fs::temp_directory_path() / ("format_batch_test_" + std::to_string(::getpid()))) {
+            fs::create_directories(path);
+        }
+        ~TempDir() { fs::remove_all(path); }
+
+        fs::path write(const std::string &name, const std::string &text) const {
+            const auto p = path / name;
+            std::ofstream(p, std::ios::binary) << text;
+            return p;
+        }
+    };
+
+    std::string sample(int n) {
+        std::string text = "subroutine s" + std::to_string(n) + "()\n";
+        for (int i = 0; i < n * 10; ++i)
+            text += "x=x+" + std::to_string(i) + "\n";
+        text += "end subroutine s" + std::to_string(n) + "\n";
+        return text;
+    }
+}
+
+int main() {
+    "batch results match single-file formatting, in input order"_test = [] {
+        given("Files of very different sizes") = [] {
+            TempDir dir;
+            std::vector<fs::path> paths;
+            std::vector<std::string> texts;
+            for (int i = 0; i < 40; ++i) {
+                texts.push_back(sample((i * 7) % 13));
+                paths.push_back(dir.write("f" + std::to_string(i) + ".f90", texts.back()));
+            }
+
+            std::vector<fs::path> reported;
+            const auto results = format_files(paths, {.threads = 4},
+                                              [&](const BatchResult &r) { reported.push_back(r.path); });
+
+            then("Every file is formatted as the formatter would, and reported in order.") = [&] {
+                expect(results.size() == paths.size());
+                expect(std::ranges::equal(reported, paths));
+
+                const FortranFormatter formatter;
+                for (std::size_t i = 0; i < paths.size(); ++i) {
+                    expect(results[i].ok());
+                    expect(results[i].path == paths[i]);
+                    const auto formatted = formatter.format(texts[i]);
+                    expect(results[i].changed == (formatted != texts[i])) << i;
+                    expect(results[i].output == (results[i].changed ? formatted : "")) << i;
+                }
+            };
+        };
+    };
+
+    "unreadable files are reported, not thrown"_test = [] {
+        TempDir dir;
+        const std::vector<fs::path> paths{
+            dir.write("ok.f90", "x = 1\n"),
+            dir.path / "missing.f90",
+        };
+
+        const auto results = format_files(paths, {.threads = 2});
+
+        expect(results[0].ok());
+        expect(!results[0].changed);
+        expect(results[0].output.empty());
+        expect(!results[1].ok());
+        expect(results[1].output.empty());
+    };
+
+    "outputs can be dropped once reported"_test = [] {
+        TempDir dir;
+        std::vector<fs::path> paths;
+        for (int i = 0; i < 8; ++i) paths.push_back(dir.write("g" + std::to_string(i) + ".f90", sample(i + 1)));
+
+        std::vector<std::string> reported;
+        const auto results = format_files(paths, {.threads = 3, .keep_output = false},
+                                          [&](const BatchResult &r) { reported.push_back(r.output); });
+
+        const FortranFormatter formatter;
+        for (std::size_t i = 0; i < paths.size(); ++i) {
+            expect(reported[i] == formatter.format(sample(static_cast<int>(i) + 1))) << i;
+            expect(results[i].changed);
+            expect(results[i].output.empty());
+        }
+    };
+
+    "dropped outputs wait for at most one window"_test = [] {
+        given("Files that only exist once the file a window before them is reported") = [] {
+            TempDir dir;
+            constexpr std::size_t count = 24;
+            constexpr std::size_t window = 4;
+            std::vector<fs::path> paths;
+            for (std::size_t i = 0; i < count; ++i) {
+                const auto name = "w" + std::to_string(i) + ".f90";
+                paths.push_back(i < window ? dir.write(name, sample(static_cast<int>(i % 5) + 1)) : dir.path / name);
+            }
+
+            std::size_t reported = 0;
+            const auto results = format_files(paths, {.threads = 3, .keep_output = false, .window = window},
+                                              [&](const BatchResult &r) {
+                                                  const std::size_t i = reported++;
+                                                  expect(r.path == paths[i]);
+                                                  if (i + window < count)
+                                                      dir.write(paths[i + window].filename().string(),
+                                                                sample(static_cast<int>((i + window) % 5) + 1));
+                                              });
+
+            then("No file is read before the one a window earlier was reported.") = [&] {
+                expect(reported == count);
+                for (std::size_t i = 0; i < count; ++i) {
+                    expect(results[i].ok()) << i << results[i].error;
+                    expect(results[i].changed);
+                    expect(results[i].output.empty());
+                }
+            };
+        };
+    };
+
+    "an empty batch"_test = [] {
+        expect(format_files({}).empty());
+    };
+}
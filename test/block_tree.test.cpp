@@ -0,0 +1,110 @@
+#include <ut.hpp>
+#include "block_tree.hpp"
+#include "cst.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include <ranges>
+#include <vector>
+
+using namespace boost::ut;
+using bdd::given;
+using bdd::when;
+using bdd::then;
+
+static std::vector<uint32_t> children_of(const FlatBlockTree &tree, uint32_t b) {
+    std::vector<uint32_t> out;
+    for (uint32_t c : tree.children(b)) out.push_back(c);
+    return out;
+}
+
+static std::vector<UnwrappedLine> unwrap(const std::string &src) {
+    FortranTokenizer tz(src);
+    const auto tokens = tz.tokenize();
+    return UnwrappedLineParser(tokens).parse();
+}
+
+int main() {
+    "flat tree: sibling and nested blocks"_test = [] {
+        given("a module with two subroutines, one holding an if and a do") = [] {
+            const std::string src =
+                "module m\n"
+                "contains\n"
+                "  subroutine a()\n"
+                "    if (x) then\n"
+                "      y = 1\n"
+                "    end if\n"
+                "    do i = 1, 3\n"
+                "    end do\n"
+                "  end subroutine a\n"
+                "  subroutine b()\n"
+                "  end subroutine b\n"
+                "end module m\n";
+
+            const auto lines = unwrap(src);
+            FlatBlockTreeBuilder builder;
+            const auto cst = build_cst(lines, &builder);
+            const auto &tree = builder.tree;
+
+            then("blocks are numbered in preorder") = [&] {
+                expect(tree.size() == 6_ul); // root, m, a, if, do, b
+                expect(cst[tree.begin(1)].kind == NodeKind::Module);
+                expect(cst[tree.begin(2)].kind == NodeKind::Subroutine);
+                expect(cst[tree.begin(3)].kind == NodeKind::IfConstruct);
+                expect(cst[tree.begin(4)].kind == NodeKind::Do);
+                expect(cst[tree.begin(5)].kind == NodeKind::Subroutine);
+            };
+
+            then("end lines close the innermost block") = [&] {
+                expect(cst[tree.end(1)].kind == NodeKind::EndModule);
+                expect(cst[tree.end(2)].kind == NodeKind::EndSubroutine);
+                expect(cst[tree.end(3)].kind == NodeKind::EndIf);
+                expect(cst[tree.end(4)].kind == NodeKind::EndDo);
+                expect(tree.end(5) == 10_u);
+                expect(tree.end(FlatBlockTree::root) == FlatBlockTree::none);
+            };
+
+            then("subroutines are siblings under the module") = [&] {
+                expect(std::ranges::equal(children_of(tree, 1), std::vector<uint32_t>{2, 5}));
+                expect(std::ranges::equal(children_of(tree, 2), std::vector<uint32_t>{3, 4}));
+                expect(tree.parent(3) == 2_u);
+                expect(tree.depth(1) == 0_i);
+                expect(tree.depth(4) == 2_i);
+            };
+        };
+    };
+
+    "flat tree: same result from a range table and after the fact"_test = [] {
+        const std::string src =
+            "program p\n"
+            "  select case (k)\n"
+            "  case (1)\n"
+            "  end select\n"
+            "end program p\n";
+
+        FortranTokenizer tz(src);
+        const auto tokens = tz.tokenize();
+        const auto table = UnwrappedLineParser(tokens).parse_ranges();
+
+        FlatBlockTreeBuilder builder;
+        const auto cst = build_cst(table, &builder);
+        const auto tree = FlatBlockTreeBuilder::build(cst);
+
+        expect(tree.size() == 3_ul);
+        expect(std::ranges::equal(tree.begins(), builder.tree.begins()));
+        expect(std::ranges::equal(tree.ends(), builder.tree.ends()));
+        expect(cst[tree.begin(2)].kind == NodeKind::SelectCase);
+        expect(cst[tree.end(2)].kind == NodeKind::EndSelect);
+    };
+
+    "flat tree: unclosed and stray ends"_test = [] {
+        const auto lines = unwrap("end do\nsubroutine s()\n  do i = 1, 2\n");
+        FlatBlockTreeBuilder builder;
+        build_cst(lines, &builder);
+        const auto &tree = builder.tree;
+
+        expect(tree.size() == 3_ul);
+        expect(tree.end(1) == FlatBlockTree::none);
+        expect(tree.end(2) == FlatBlockTree::none);
+        expect(tree.parent(2) == 1_u);
+    };
+}
@@ -0,0 +1,88 @@
+#include <ut.hpp>
+#include "corpus_gen.hpp"
+#include "block_tree.hpp"
+#include "cst.hpp"
+#include "formatter.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include <set>
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    "the same seed gives the same corpus"_test = [] {
+        const auto a = generate_corpus({.seed = 7, .size = 64 << 10});
+        const auto b = generate_corpus({.seed = 7, .size = 64 << 10});
+        const auto c = generate_corpus({.seed = 8, .size = 64 << 10});
+
+        expect(a == b);
+        expect(a != c);
+        expect(a.size() >= 64u << 10);
+    };
+
+    "chunks stream the same text"_test = [] {
+        const CorpusOptions options{.seed = 3, .size = 3 << 20};
+        std::string streamed;
+        std::size_t chunks = 0;
+        CorpusGenerator gen(options);
+        gen.generate([&](std::string_view text) {
+            streamed += text;
+            ++chunks;
+        });
+
+        expect(chunks > 1_u);
+        expect(gen.written() == streamed.size());
+        expect(streamed == generate_corpus(options));
+    };
+
+    "every node kind appears and every block closes"_test = [] {
+        given("A messy corpus of a few hundred kilobytes") = [] {
+            const auto src = generate_corpus({.seed = 11, .size = 256 << 10});
+
+            FortranTokenizer tz(src);
+            const auto tokens = tz.tokenize();
+            const auto lines = UnwrappedLineParser(tokens).parse_ranges();
+            const auto cst = build_cst(lines);
+
+            then("The classifier sees all of its kinds.") = [&] {
+                std::set<NodeKind> kinds;
+                for (const auto &node : cst) kinds.insert(node.kind);
+                expect(kinds.size() == static_cast<std::size_t>(NodeKind::EndType) + 1);
+            };
+
+            then("Blocks are balanced.") = [&] {
+                const auto tree = FlatBlockTreeBuilder::build(cst);
+                expect(tree.size() > 1_u);
+                for (uint32_t b = 1; b < tree.size(); ++b) expect(tree.end(b) != FlatBlockTree::none);
+            };
+
+            then("Formatting it is idempotent.") = [&] {
+                const FortranFormatter formatter;
+                const auto once = formatter.format(src);
+                expect(once != src);
+                expect(formatter.format(once) == once);
+            };
+        };
+    };
+
+    "options shape the output"_test = [] {
+        const auto count = [](const std::string &s, std::string_view what) {
+            std::size_t n = 0;
+            for (auto at = s.find(what); at != std::string::npos; at = s.find(what, at + 1)) ++n;
+            return n;
+        };
+
+        const auto plain = generate_corpus({.size = 64 << 10, .comment_percent = 0, .messy = false});
+        const auto commented = generate_corpus({.size = 64 << 10, .comment_percent = 80, .messy = false});
+        expect(count(commented, "! ") > 4 * count(plain, "! "));
+
+        const auto flat = generate_corpus({.size = 64 << 10, .max_depth = 1, .messy = false});
+        expect(!flat.contains("\n" + std::string(8, ' ') + "do "));
+
+        const auto tidy = generate_corpus({.size = 64 << 10, .messy = false});
+        const auto messy = generate_corpus({.size = 64 << 10, .messy = true});
+        expect(!tidy.contains("END ") && messy.contains("END "));
+    };
+}
@@ -63,6 +63,16 @@ int main() {
         expect(get_node(0, cst).kind == NodeKind::Module);
         expect(get_node(1, cst).kind == NodeKind::EndModule);
     };
+    "module procedure"_test = [parse, get_node] {
+        std::stringstream src_stream;
+        src_stream << "module procedure s" << std::endl;
+        src_stream << "MODULE PROCEDURE S" << std::endl;
+        const auto src = src_stream.str();
+        const auto lines = parse(src);
+        const auto cst = build_cst(lines);
+        expect(get_node(0, cst).kind == NodeKind::Declaration);
+        expect(get_node(1, cst).kind == NodeKind::Declaration);
+    };
     "function"_test = [parse, get_node] {
         std::stringstream src_stream;
         src_stream << "function main" << std::endl;
@@ -301,4 +311,51 @@ int main() {
         const auto cst = build_cst(lines);
         expect(get_node(0, cst).kind == NodeKind::Comment);
     };
+    "upper case keywords"_test = [parse, get_node] {
+        std::stringstream src_stream;
+        src_stream << "SUBROUTINE foo" << std::endl;
+        src_stream << "DO i = 1, 10" << std::endl;
+        src_stream << "END DO" << std::endl;
+        src_stream << "End Subroutine" << std::endl;
+        const auto src = src_stream.str();
+        const auto lines = parse(src);
+        const auto cst = build_cst(lines);
+        expect(get_node(0, cst).kind == NodeKind::Subroutine);
+        expect(get_node(1, cst).kind == NodeKind::Do);
+        expect(get_node(2, cst).kind == NodeKind::EndDo);
+        expect(get_node(3, cst).kind == NodeKind::EndSubroutine);
+    };
+
+    "range lines classify like copied lines"_test = [] {
+        const std::string_view src =
+            "program p\n"
+            "  implicit none\n"
+            "  integer :: i, &\n"
+            "      j\n"
+            "contains\n"
+            "  subroutine s()\n"
+            "    if (i > 0) then\n"
+            "      call f(i, &\n"
+            "             j)\n"
+            "    end if\n"
+            "  end subroutine s\n"
+            "end program p\n";
+
+        FortranTokenizer tz(src);
+        const auto tokens = tz.tokenize();
+        const UnwrappedLineParser parser(tokens);
+        const auto lines = parser.parse();
+        const auto table = parser.parse_ranges();
+
+        const auto copied = build_cst(lines);
+        const auto ranged = build_cst(table);
+
+        expect(ranged.size() == copied.size());
+        for (std::size_t i = 0; i < ranged.size(); ++i) {
+            expect(ranged[i].kind == copied[i].kind) << i;
+            expect(ranged[i].prev_kind == copied[i].prev_kind) << i;
+            expect(ranged[i].index == i);
+            expect(copied[i].index == i);
+        }
+    };
 };
\ No newline at end of file
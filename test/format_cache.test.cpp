@@ -0,0 +1,132 @@
+#include <ut.hpp>
+#include "batch.hpp"
+#include "format_cache.hpp"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace fs = std::filesystem;
+
+namespace {
+    struct TempDir {
+        fs::path path;
+
+        TempDir() : path(fs::temp_directory_path() / ("format_cache_test_" + std::to_string(::getpid()))) {
+            fs::create_directories(path);
+        }
+        ~TempDir() { fs::remove_all(path); }
+
+        fs::path write(const std::string &name, const std::string &text) const {
+            const auto p = path / name;
+            std::ofstream(p, std::ios::binary) << text;
+            return p;
+        }
+    };
+
+    std::size_t entries(const fs::path &dir) {
+        std::size_t n = 0;
+        for (const auto &e : fs::recursive_directory_iterator(dir))
+            if (e.is_regular_file()) ++n;
+        return n;
+    }
+}
+
+int main() {
+    "hash64 is XXH64"_test = [] {
+        expect(hash64("") == 0xEF46DB3751D8E999ull);
+        expect(hash64("a") == 0xD24EC4F1A98C6E5Bull);
+        expect(hash64("abc") == 0x44BC2CF5AD770999ull);
+        expect(hash64("Nobody inspects the spammish repetition") == 0xFBCEA83C8A378BF1ull);
+        expect(hash64("abc", 1) != hash64("abc"));
+    };
+
+    "lookup after store"_test = [] {
+        given("An empty cache") = [] {
+            TempDir dir;
+            const FormatCache cache(dir.path / "cache");
+
+            then("Lookups miss until the result is stored.") = [&] {
+                expect(!cache.lookup("x=1\n").has_value());
+
+                cache.store("x=1\n", "x = 1\n");
+                cache.store("y = 2\n", "y = 2\n");
+
+                const auto changed = cache.lookup("x=1\n");
+                expect(changed.has_value() && changed->changed && changed->output == "x = 1\n");
+
+                const auto same = cache.lookup("y = 2\n");
+                expect(same.has_value() && !same->changed && same->output.empty());
+
+                expect(!cache.lookup("x=1 \n").has_value());
+            };
+        };
+    };
+
+    "the key covers the options"_test = [] {
+        TempDir dir;
+        FormatCache(dir.path, {}).store("integer :: n\n", "integer :: n\n");
+
+        expect(FormatCache(dir.path, {}).lookup("integer :: n\n").has_value());
+        expect(!FormatCache(dir.path, {.keyword_case = KeywordCase::Upper}).lookup("integer :: n\n").has_value());
+        expect(!FormatCache(dir.path, {.indent_width = 4}).lookup("integer :: n\n").has_value());
+    };
+
+    "corrupt entries miss"_test = [] {
+        TempDir dir;
+        const FormatCache cache(dir.path);
+        cache.store("x=1\n", "x = 1\n");
+
+        for (const auto &e : fs::recursive_directory_iterator(dir.path))
+            if (e.is_regular_file()) std::ofstream(e.path(), std::ios::binary) << "?";
+
+        expect(!cache.lookup("x=1\n").has_value());
+    };
+
+    "concurrent writers leave one complete entry"_test = [] {
+        TempDir dir;
+        const FormatCache cache(dir.path);
+        const std::string output(100000, 'x');
+
+        std::vector<std::jthread> writers;
+        for (int t = 0; t < 8; ++t)
+            writers.emplace_back([&] {
+                for (int i = 0; i < 20; ++i) cache.store("source\n", output);
+            });
+        writers.clear();
+
+        const auto hit = cache.lookup("source\n");
+        expect(hit.has_value() && hit->output == output);
+        expect(entries(dir.path) == 1_u);
+    };
+
+    "a warm batch is answered from the cache"_test = [] {
+        given("Files formatted once with a cache") = [] {
+            TempDir dir;
+            const std::vector<fs::path> paths{
+                dir.write("a.f90", "subroutine a()\nx=1\nend subroutine a\n"),
+                dir.write("b.f90", "subroutine b()\n  x = 1\nend subroutine b\n"),
+            };
+            const BatchOptions options{.threads = 2, .cache = dir.path / "cache"};
+
+            const auto cold = format_files(paths, options);
+            const auto warm = format_files(paths, options);
+
+            then("The second run formats nothing and gives the same results.") = [&] {
+                for (std::size_t i = 0; i < paths.size(); ++i) {
+                    expect(cold[i].ok() && warm[i].ok());
+                    expect(!cold[i].cached);
+                    expect(warm[i].cached);
+                    expect(warm[i].output == cold[i].output);
+                    expect(warm[i].changed == cold[i].changed);
+                }
+                expect(warm[0].changed);
+                expect(!warm[1].changed);
+            };
+        };
+    };
+}
@@ -0,0 +1,168 @@
+#include <ut.hpp>
+#include "formatter.hpp"
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    const auto format = [](std::string_view src, FormatOptions options = {}) {
+        return FortranFormatter(options).format(src);
+    };
+
+    "reindents nested blocks"_test = [format] {
+        given("A program with badly indented nested constructs") = [format] {
+            const std::string src =
+                "PROGRAM p\n"
+                "implicit none\n"
+                "      integer :: i\n"
+                "do i = 1, 3\n"
+                "if (i > 1) then\n"
+                "print *, i\n"
+                "else\n"
+                "call g(i)\n"
+                "end if\n"
+                "  end do\n"
+                "contains\n"
+                "subroutine g(k)\n"
+                "integer, intent(in) :: k\n"
+                "select case (k)\n"
+                "case (1)\n"
+                "k2 = 0\n"
+                "end select\n"
+                "end subroutine g\n"
+                "END PROGRAM p\n";
+
+            then("Each line is indented by its block depth.") = [&] {
+                expect(format(src) ==
+                    "program p\n"
+                    "  implicit none\n"
+                    "  integer :: i\n"
+                    "  do i = 1, 3\n"
+                    "    if (i > 1) then\n"
+                    "      print *, i\n"
+                    "    else\n"
+                    "      call g(i)\n"
+                    "    end if\n"
+                    "  end do\n"
+                    "contains\n"
+                    "  subroutine g(k)\n"
+                    "    integer, intent(in) :: k\n"
+                    "    select case (k)\n"
+                    "    case (1)\n"
+                    "      k2 = 0\n"
+                    "    end select\n"
+                    "  end subroutine g\n"
+                    "end program p\n");
+            };
+        };
+    };
+
+    "normalizes token spacing"_test = [format] {
+        expect(format("x=a( 1 ,2 )+b%c   ! note   \n") == "x = a(1, 2)+b%c ! note\n");
+        expect(format("x = 1 ! note \t \n! only   \ny=2   \n") == "x = 1 ! note\n! only\ny = 2\n");
+        expect(format("x = 1 !   \n") == "x = 1 !\n");
+        expect(format("integer::n,m\n") == "integer :: n, m\n");
+        expect(format("if(a==b.and.c/=d) y=f(k=1)\n") == "if (a == b.and.c /= d) y = f(k=1)\n");
+        expect(format("p=>q\n") == "p => q\n");
+        expect(format("a(1 : n) = b(:)\n") == "a(1:n) = b(:)\n");
+        expect(format("use m, only:x\n") == "use m, only: x\n");
+        expect(format("x = 1.0_dp ; y = 2\n") == "x = 1.0_dp; y = 2\n");
+    };
+
+    "keyword case"_test = [format] {
+        expect(format("Integer :: Count\n") == "integer :: Count\n");
+        expect(format("integer :: n\n", {.keyword_case = KeywordCase::Upper}) == "INTEGER :: n\n");
+        expect(format("InTeGer :: n\n", {.keyword_case = KeywordCase::Preserve}) == "InTeGer :: n\n");
+    };
+
+    "continuation lines"_test = [format] {
+        const std::string src =
+            "subroutine s()\n"
+            "call f(a,   &\n"
+            "  b,&\n"
+            "         &c)\n"
+            "end subroutine s\n";
+
+        expect(format(src) ==
+            "subroutine s()\n"
+            "  call f(a, &\n"
+            "      b, &\n"
+            "      &c)\n"
+            "end subroutine s\n");
+    };
+
+    "blank lines, comments and preprocessor lines"_test = [format] {
+        const std::string src =
+            "module m\n"
+            "\n"
+            "\n"
+            "\n"
+            "      ! about x\n"
+            "#ifdef  X\n"
+            "integer :: x   \n"
+            "end module m";
+
+        expect(format(src) ==
+            "module m\n"
+            "\n"
+            "  ! about x\n"
+            "#ifdef  X\n"
+            "  integer :: x\n"
+            "end module m\n");
+        expect(format(src, {.max_blank_lines = 2}).starts_with("module m\n\n\n  !"));
+    };
+
+    "empty input"_test = [format] {
+        expect(format("") == "");
+        expect(format("   ") == "");
+        expect(format("\n") == "\n");
+    };
+
+    "indent width"_test = [format] {
+        expect(format("do i = 1, 2\nx = i\nend do\n", {.indent_width = 4}) ==
+               "do i = 1, 2\n    x = i\nend do\n");
+    };
+
+    "formatting is idempotent"_test = [format] {
+        const std::string src =
+            "MODULE m\n"
+            "contains\n"
+            "  PURE FUNCTION f(x) result(y)\n"
+            "real,intent(in)::x(:)\n"
+            "real :: y\n"
+            "      y=sum( x(1:size(x)) )*2.0e-3_dp&\n"
+            "  +1\n"
+            "if(y<0)y=-y\n"
+            "end function f\n"
+            "end module m\n";
+
+        const auto once = format(src);
+        expect(format(once) == once) << once;
+
+        const auto binary = format("a=f(x) - 1\nn = size(x)-1\n");
+        expect(binary == "a = f(x) - 1\nn = size(x)-1\n") << binary;
+        expect(format(binary) == binary);
+    };
+
+    "output writer grows past its estimate"_test = [] {
+        OutputWriter out(2);
+        out.put("abc");
+        out.put_spaces(3);
+        out.put('x');
+        expect(out.view() == "abc   x");
+        expect(out.take() == "abc   x");
+        expect(out.empty());
+    };
+
+    "output writer reuses its buffer after clear"_test = [] {
+        OutputWriter out(16);
+        out.put("first line");
+        const char *buffer = out.view().data();
+        out.clear();
+        expect(out.empty());
+        out.put("second");
+        expect(out.view() == "second");
+        expect(out.view().data() == buffer);
+    };
+}
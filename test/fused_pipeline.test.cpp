@@ -0,0 +1,122 @@
+#include <ut.hpp>
+#include "fused_pipeline.hpp"
+#include "block_tree.hpp"
+#include "corpus_gen.hpp"
+#include "cst.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    // What a visitor can observe of a node; the line itself is gone
+    // once on_node returns.
+    struct Seen {
+        NodeKind kind;
+        NodeKind prev_kind;
+        std::size_t index;
+        std::size_t tokens;
+        std::string first;
+
+        bool operator==(const Seen &) const = default;
+    };
+
+    struct Recorder : CSTVisitor {
+        std::vector<Seen> seen;
+
+        void on_node(const CSTNode &node) override {
+            const auto &tokens = node.line->tokens;
+            seen.push_back({node.kind, node.prev_kind, node.index, tokens.size(),
+                            tokens.empty() ? std::string() : std::string(tokens.front().text)});
+        }
+    };
+
+    std::vector<Seen> expected(std::string_view src) {
+        FortranTokenizer tz(src);
+        const auto tokens = tz.tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse();
+        Recorder recorder;
+        build_cst(lines, &recorder);
+        return recorder.seen;
+    }
+
+    std::vector<Seen> fused(std::string_view src) {
+        Recorder recorder;
+        FusedPipeline(recorder).run(src);
+        return recorder.seen;
+    }
+
+    std::vector<Seen> fused_chunks(std::string_view src, std::size_t chunk_size) {
+        Recorder recorder;
+        FusedPipeline pipeline(recorder);
+        for (std::size_t pos = 0; pos < src.size(); pos += chunk_size)
+            pipeline.feed(src.substr(pos, chunk_size));
+        pipeline.finish();
+        return recorder.seen;
+    }
+
+    const std::string sample =
+        "program main\n"
+        "  integer :: i, &\n"
+        "      j\n"
+        "  x = - 3 + y%z  \n"
+        "\n"
+        "  if (x > 0) then & ! not a continuation\n"
+        "    call foo(x, 'a &\n"
+        "b')\n"
+        "  end if\n"
+        "end program main";
+}
+
+int main() {
+    "fused pipeline visits the nodes build_cst does"_test = [] {
+        for (const std::string_view src : {std::string_view(sample), std::string_view(""),
+                                           std::string_view("\n"), std::string_view("x = 1 &\n")}) {
+            const auto want = expected(src);
+            expect(fused(src) == want) << src;
+            for (const std::size_t chunk : {1uz, 5uz, 64uz})
+                expect(fused_chunks(src, chunk) == want) << src << chunk;
+        }
+    };
+
+    "a generated corpus"_test = [] {
+        given("a messy corpus of a few hundred kilobytes") = [] {
+            const auto src = generate_corpus({.seed = 5, .size = 256 << 10});
+            const auto want = expected(src);
+
+            then("whole and chunked runs agree with build_cst") = [&] {
+                expect(fused(src) == want);
+                expect(fused_chunks(src, 4093) == want);
+            };
+
+            then("a flat block tree built on the fly matches the batch one") = [&] {
+                FlatBlockTreeBuilder builder;
+                FusedPipeline(builder).run(src);
+
+                FortranTokenizer tz(src);
+                const auto tokens = tz.tokenize();
+                const auto tree = FlatBlockTreeBuilder::build(build_cst(UnwrappedLineParser(tokens).parse_ranges()));
+
+                expect((builder.tree.size() == tree.size()) >> fatal);
+                expect(std::ranges::equal(builder.tree.begins(), tree.begins()));
+                expect(std::ranges::equal(builder.tree.ends(), tree.ends()));
+                expect(std::ranges::equal(builder.tree.parents(), tree.parents()));
+            };
+
+            then("the window is one logical line") = [&] {
+                Recorder recorder;
+                FusedPipeline pipeline(recorder);
+                pipeline.run(src);
+
+                std::size_t longest = 0;
+                for (const auto &s : want) longest = std::max(longest, s.tokens);
+                expect(pipeline.lines() == want.size());
+                expect(pipeline.max_line_tokens() == longest);
+                expect(longest < 1000_u);
+            };
+        };
+    };
+}
@@ -0,0 +1,217 @@
+#include <ut.hpp>
+#include "incremental.hpp"
+#include "cst.hpp"
+#include <array>
+#include <random>
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    const std::string sample =
+        "module m\n"
+        "contains\n"
+        "  subroutine s(a, &\n"
+        "      b)\n"
+        "    integer :: a, b\n"
+        "    do i = 1, 10\n"
+        "      if (a > 0) then\n"
+        "        print *, 'it''s', \"two\n"
+        "lines\"\n"
+        "      else\n"
+        "        a = - 3 ! note\n"
+        "      end if\n"
+        "    end do\n"
+        "  end subroutine s\n"
+        "end module m\n";
+
+    // Compares the document with a parse of its text from scratch.
+    bool matches_full_parse(const IncrementalDocument &doc) {
+        const std::string text = doc.text();
+        if (text.size() != doc.text_size()) return false;
+
+        FortranTokenizer tz(text);
+        const auto tokens = tz.tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse();
+        const auto cst = build_cst(lines);
+        const auto blocks = FlatBlockTreeBuilder::build(cst);
+
+        if (lines.size() != doc.size()) return false;
+        for (std::size_t i = 0; i < lines.size(); ++i) {
+            const auto &a = lines[i].tokens;
+            const auto &b = doc[i].tokens;
+            if (!std::ranges::equal(a, b, [](const Token &x, const Token &y) {
+                    return x.kind == y.kind && x.text == y.text && x.column == y.column;
+                }))
+                return false;
+            if (!a.empty() && a.front().kind != TokenKind::EndOfFile && a.front().line != doc.first_line(i))
+                return false;
+            if (cst[i].kind != doc.cst()[i].kind || cst[i].prev_kind != doc.cst()[i].prev_kind) return false;
+            if (doc.cst()[i].index != i || doc.cst()[i].line != &doc[i]) return false;
+        }
+
+        if (blocks.size() != doc.blocks().size()) return false;
+        for (uint32_t b = 0; b < blocks.size(); ++b)
+            if (blocks.first_child(b) != doc.blocks().first_child(b) ||
+                blocks.next_sibling(b) != doc.blocks().next_sibling(b))
+                return false;
+
+        return std::ranges::equal(blocks.begins(), doc.blocks().begins()) &&
+               std::ranges::equal(blocks.ends(), doc.blocks().ends()) &&
+               std::ranges::equal(blocks.parents(), doc.blocks().parents());
+    }
+}
+
+int main() {
+    "a fresh document matches a full parse"_test = [] {
+        expect(matches_full_parse(IncrementalDocument(sample)));
+        expect(matches_full_parse(IncrementalDocument("")));
+        expect(matches_full_parse(IncrementalDocument("x = 1")));
+        expect(matches_full_parse(IncrementalDocument("x = 1 &\n")));
+    };
+
+    "an edit inside one line touches only that line"_test = [] {
+        given("A document") = [] {
+            IncrementalDocument doc(sample);
+            const std::size_t at = sample.find("a, b\n");
+
+            when("A variable is renamed") = [&] {
+                const auto result = doc.apply({at, 1, "alpha"});
+
+                then("One line is rebuilt and the tree keeps its shape.") = [&] {
+                    expect(result.removed == 1_ul);
+                    expect(result.inserted == 1_ul);
+                    expect(!result.tree_rebuilt);
+                    expect(doc[result.first].tokens.contains_token("alpha"));
+                    expect(matches_full_parse(doc));
+                };
+            };
+        };
+    };
+
+    "opening a string rescans up to the next safe split"_test = [] {
+        IncrementalDocument doc(sample);
+        const std::size_t at = sample.find("integer");
+        const auto result = doc.apply({at, 0, "'"});
+
+        expect(result.removed > 1_ul);
+        expect(matches_full_parse(doc));
+
+        doc.apply({at, 1, ""});
+        expect(doc.text() == sample);
+        expect(matches_full_parse(doc));
+    };
+
+    "structural edits rebuild the tree"_test = [] {
+        IncrementalDocument doc(sample);
+        const std::size_t at = sample.find("    end do\n");
+        const auto result = doc.apply({at, std::string_view("    end do\n").size(), ""});
+
+        expect(result.tree_rebuilt);
+        expect(result.rebuilt_block == FlatBlockTree::root);
+        expect(result.inserted == 0_ul);
+        expect(matches_full_parse(doc));
+    };
+
+    "a balanced structural edit rebuilds only its block"_test = [] {
+        IncrementalDocument doc(sample);
+        const std::size_t at = sample.find("      else\n");
+        const auto result = doc.apply({at, 0, "      do j = 1, 2\n      end do\n"});
+
+        expect(result.tree_rebuilt);
+        expect(result.rebuilt_block != FlatBlockTree::root);
+        expect(result.rebuilt_block != FlatBlockTree::none);
+        expect(doc.cst()[doc.blocks().begin(result.rebuilt_block)].kind == NodeKind::IfConstruct);
+        expect(matches_full_parse(doc));
+
+        const auto inner = doc.blocks().first_child(result.rebuilt_block);
+        expect(doc.blocks().begin(inner) == result.first);
+        expect(doc.blocks().end(inner) == result.first + 1);
+    };
+
+    "edits at the ends of the text"_test = [] {
+        IncrementalDocument doc(sample);
+        doc.apply({0, 0, "! header\n"});
+        expect(matches_full_parse(doc));
+        doc.apply({doc.text_size(), 0, "program p\nend program p"});
+        expect(matches_full_parse(doc));
+        doc.apply({0, doc.text_size(), ""});
+        expect(doc.size() == 1_ul);
+        expect(matches_full_parse(doc));
+        doc.apply({0, 0, "x = 1\n"});
+        expect(matches_full_parse(doc));
+    };
+
+    "random edits keep the document consistent"_test = [] {
+        const std::array<std::string_view, 16> snippets{
+            "", "x", "\n", "&\n", "'", "\"", " - 3", "! c\n", "end do\n", "do i = 1, 2\n",
+            "if (a) then\n", "end if\n", "  ", "subroutine t()\n",
+            "\ndo j = 1, 2\nend do\n", "\nif (b) then\nx = 1\nelse\nend if\n",
+        };
+
+        std::mt19937 rng(12345);
+        IncrementalDocument doc(sample);
+
+        for (int step = 0; step < 500; ++step) {
+            const std::size_t size = doc.text_size();
+            const std::size_t offset = std::uniform_int_distribution<std::size_t>(0, size)(rng);
+            const std::size_t length = std::uniform_int_distribution<std::size_t>(0, std::min<std::size_t>(8, size - offset))(rng);
+            const auto replacement = snippets[std::uniform_int_distribution<std::size_t>(0, snippets.size() - 1)(rng)];
+
+            std::string expected = doc.text();
+            expected.replace(offset, length, replacement);
+
+            doc.apply({offset, length, replacement});
+            expect(doc.text() == expected);
+            if (!matches_full_parse(doc)) {
+                expect(false) << "step" << step;
+                break;
+            }
+        }
+    };
+
+    "balanced block edits patch the tree in place"_test = [] {
+        const std::array<std::string_view, 3> blocks{
+            "do j = 1, 2\nend do\n", "if (b) then\nx = 1\nelse\nend if\n", "select case (k)\ncase (1)\nend select\n",
+        };
+
+        std::mt19937 rng(54321);
+        IncrementalDocument doc(sample);
+        std::size_t local = 0;
+        std::size_t offset = 0;
+        std::string_view text;
+
+        for (int step = 0; step < 300; ++step) {
+            // Insert a whole block at a line start; every third step
+            // removes the block inserted just before.
+            const bool remove = step % 3 == 2;
+            if (!remove) {
+                const std::size_t line = std::uniform_int_distribution<std::size_t>(0, doc.size() - 1)(rng);
+                offset = doc.line_offset(line);
+                text = blocks[std::uniform_int_distribution<std::size_t>(0, blocks.size() - 1)(rng)];
+            }
+            const auto result = remove ? doc.apply({offset, text.size(), ""}) : doc.apply({offset, 0, text});
+            if (result.rebuilt_block != FlatBlockTree::root && result.rebuilt_block != FlatBlockTree::none) ++local;
+
+            if (!matches_full_parse(doc)) {
+                expect(false) << "step" << step;
+                break;
+            }
+        }
+        expect(local > 100_ul) << local;
+    };
+
+    "formatting the document equals formatting its text"_test = [] {
+        IncrementalDocument doc(sample);
+        doc.apply({sample.find("a = - 3"), 1, "b"});
+        const FortranFormatter formatter;
+        expect(doc.format(formatter) == formatter.format(doc.text()));
+    };
+
+    "edits outside the text throw"_test = [] {
+        IncrementalDocument doc("x = 1\n");
+        expect(throws<std::out_of_range>([&] { doc.apply({7, 0, "y"}); }));
+        expect(throws<std::out_of_range>([&] { doc.apply({3, 4, ""}); }));
+    };
+}
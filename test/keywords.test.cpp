@@ -0,0 +1,31 @@
+#include <ut.hpp>
+#include "keywords.hpp"
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+static_assert(lookup_keyword("program") == KeywordId::Program);
+static_assert(lookup_keyword("END") == KeywordId::End);
+static_assert(lookup_keyword("foo") == KeywordId::Unknown);
+
+int main() {
+    "every keyword round-trips through its spelling"_test = [] {
+        for (std::size_t i = 1; i < static_cast<std::size_t>(KeywordId::Count); ++i) {
+            const auto id = static_cast<KeywordId>(i);
+            expect(lookup_keyword(keyword_spelling(id)) == id) << keyword_spelling(id);
+        }
+    };
+
+    "lookup is case-insensitive"_test = [] {
+        expect(lookup_keyword("Subroutine") == KeywordId::Subroutine);
+        expect(lookup_keyword("ENDDO") == KeywordId::EndDo);
+        expect(lookup_keyword("ImPlIcIt") == KeywordId::Implicit);
+    };
+
+    "non-keywords are rejected"_test = [] {
+        for (std::string_view s : {"", "x", "foo", "programs", "progra", "end_", "end do",
+                                   "else if", "integer8", "_do", "d0", "recursively"}) {
+            expect(lookup_keyword(s) == KeywordId::Unknown) << s;
+        }
+    };
+}
@@ -0,0 +1,63 @@
+#include <ut.hpp>
+#include "line_index.hpp"
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    "LineIndex"_test = [] {
+        given("a source with a blank line and no final newline") = [] {
+            const std::string src = "program p\n\n  x = 1\nend";
+            const LineIndex index(src);
+
+            then("every line start is recorded") = [&] {
+                expect(index.size() == 4_u);
+                expect(index.line_start(1) == 0_u);
+                expect(index.line_start(2) == 10_u);
+                expect(index.line_start(3) == 11_u);
+                expect(index.line_start(4) == 19_u);
+            };
+
+            then("offsets map back to line and column") = [&] {
+                expect(index.position(0) == SourcePosition{1, 1});
+                expect(index.position(9) == SourcePosition{1, 10}); // the newline itself
+                expect(index.position(10) == SourcePosition{2, 1});
+                expect(index.position(13) == SourcePosition{3, 3});
+                expect(index.line_of(21) == 4_i);
+                expect(index.column_of(22) == 4_i); // one past the end
+            };
+        };
+
+        given("a piece of a larger input") = [] {
+            const LineIndex index("a\nb\n", 41);
+            then("lines are numbered from first_line") = [&] {
+                expect(index.first_line() == 41_i);
+                expect(index.size() == 3_u);
+                expect(index.line_of(2) == 42_i);
+                expect(index.line_start(43) == 4_u);
+            };
+        };
+
+        given("long lines that span several scanner blocks") = [] {
+            std::string src;
+            for (int i = 0; i < 50; ++i) src += std::string(static_cast<std::size_t>(i * 7), 'x') + '\n';
+            const LineIndex index(src);
+            then("lines agree with a byte-by-byte count") = [&] {
+                int line = 1, column = 1;
+                for (std::size_t i = 0; i < src.size(); ++i) {
+                    expect(index.position(static_cast<uint32_t>(i)) == SourcePosition{line, column}) << i;
+                    if (src[i] == '\n') { ++line; column = 1; } else ++column;
+                }
+            };
+        };
+
+        given("an empty source") = [] {
+            const LineIndex index("");
+            then("it has one empty line") = [&] {
+                expect(index.size() == 1_u);
+                expect(index.position(0) == SourcePosition{1, 1});
+            };
+        };
+    };
+}
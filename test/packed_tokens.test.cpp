@@ -0,0 +1,122 @@
+#include <ut.hpp>
+#include "packed_tokens.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include "cst.hpp"
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    const std::string sample =
+        "program main\n"
+        "  integer :: i, &\n"
+        "      j\n"
+        "  x = - 3 + y%z\n"
+        "  if (x > 0) then\n"
+        "    call foo(x, 'str')  \n"
+        "  end if\n"
+        "  ! comment\n"
+        "end program main\n";
+}
+
+int main() {
+    "PackedTokens"_test = [] {
+        given("packed tokens filled by the tokenizer") = [] {
+            const auto packed = PackedTokens::from_source(sample);
+            FortranTokenizer tz(sample);
+            const auto tokens = tz.tokenize();
+
+            then("a packed token is under a third of a Token") = [] {
+                expect(sizeof(PackedToken) == 12_u);
+                expect(sizeof(PackedToken) * 3 < sizeof(Token));
+            };
+
+            then("iterators yield values: forward for ranges, input for the rest") = [] {
+                using It = PackedTokens::iterator;
+                static_assert(std::forward_iterator<It>);
+                static_assert(std::is_same_v<std::iterator_traits<It>::iterator_category, std::input_iterator_tag>);
+                static_assert(std::forward_iterator<PackedLineTokens::iterator>);
+                static_assert(std::is_same_v<std::iterator_traits<PackedLineTokens::iterator>::iterator_category,
+                                             std::input_iterator_tag>);
+                static_assert(std::is_same_v<std::iterator_traits<LineTokens::iterator>::iterator_category,
+                                             std::forward_iterator_tag>);
+            };
+
+            then("every token round-trips") = [&] {
+                expect((packed.size() == tokens.size()) >> fatal);
+                for (std::size_t i = 0; i < tokens.size(); ++i) {
+                    const Token t = packed[i];
+                    expect(t.kind == tokens[i].kind) << i;
+                    expect(t.text == tokens[i].text) << i;
+                    expect(t.line == tokens[i].line) << i;
+                    expect(t.column == tokens[i].column) << i;
+                    expect(t.keyword == tokens[i].keyword) << i;
+                }
+            };
+
+            then("the merged literal sits where its sign was") = [&] {
+                const auto it = std::ranges::find_if(packed, [](const Token &t) { return t.text == "-3"; });
+                expect((it != packed.end()) >> fatal);
+                expect((*it).line == 4_i);
+                expect((*it).column == 7_i);
+            };
+        };
+
+        given("a comment longer than 64 KiB") = [] {
+            const std::string src = "x = 1 ! " + std::string(70000, 'c') + "\ny = 2\n";
+            const auto packed = PackedTokens::from_source(src);
+
+            then("its length goes to the side table") = [&] {
+                const auto it = std::ranges::find(packed.packed(), TokenKind::Comment, &PackedToken::kind);
+                expect((it != packed.packed().end()) >> fatal);
+                const auto i = static_cast<std::size_t>(it - packed.packed().begin());
+                expect(it->length == PackedToken::spilled);
+                expect(packed.text(i).size() == 70002_u);
+                expect(packed.text(i).data() == src.data() + 6);
+                expect(packed[i + 2].text == "y");
+                expect(packed[i + 2].line == 2_i);
+            };
+        };
+    };
+
+    "line parser over packed tokens"_test = [] {
+        const auto packed = PackedTokens::from_source(sample);
+        FortranTokenizer tz(sample);
+        const auto tokens = tz.tokenize();
+
+        const auto expected = UnwrappedLineParser(tokens).parse_ranges();
+        const auto table = PackedLineParser(packed).parse_ranges();
+
+        then("the ranges are the same") = [&] {
+            expect((table.size() == expected.size()) >> fatal);
+            for (std::size_t i = 0; i < table.size(); ++i) {
+                expect(table.ranges()[i].begin == expected.ranges()[i].begin) << i;
+                expect(table.ranges()[i].end == expected.ranges()[i].end) << i;
+            }
+            expect(std::ranges::equal(table.splices(), expected.splices()));
+        };
+
+        then("packed lines classify like token lines") = [&] {
+            const auto a = build_cst(table);
+            const auto b = build_cst(expected);
+            expect((a.size() == b.size()) >> fatal);
+            for (std::size_t i = 0; i < a.size(); ++i) expect(a[i].kind == b[i].kind) << i;
+            expect(table[1].tokens.contains_token("j"));
+            expect(table[1].tokens.first_token_is(KeywordId::Integer));
+        };
+
+        then("parse() copies them into Tokens") = [&] {
+            const auto lines = PackedLineParser(packed).parse();
+            const auto copied = UnwrappedLineParser(tokens).parse();
+            expect((lines.size() == copied.size()) >> fatal);
+            for (std::size_t i = 0; i < lines.size(); ++i) {
+                expect((lines[i].tokens.size() == copied[i].tokens.size()) >> fatal) << i;
+                for (std::size_t j = 0; j < lines[i].tokens.size(); ++j)
+                    expect(lines[i].tokens[j].text == copied[i].tokens[j].text) << i << j;
+            }
+        };
+    };
+}
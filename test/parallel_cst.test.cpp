@@ -0,0 +1,117 @@
+#include <ut.hpp>
+#include "parallel_cst.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include <array>
+#include <atomic>
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    std::string sample(int repeats) {
+        std::string text;
+        for (int i = 0; i < repeats; ++i) {
+            text += "module m\n";
+            text += "contains\n";
+            text += "\n";
+            text += "  subroutine s(a)\n";
+            text += "    integer :: a\n";
+            text += "    ! comment\n";
+            text += "    if (a > 0) then\n";
+            text += "      call f(a)\n";
+            text += "    else\n";
+            text += "      a = 1\n";
+            text += "    end if\n";
+            text += "  end subroutine s\n";
+            text += "end module m\n";
+        }
+        return text;
+    }
+
+    bool same_nodes(const std::vector<CSTNode> &a, const std::vector<CSTNode> &b) {
+        return std::ranges::equal(a, b, [](const CSTNode &x, const CSTNode &y) {
+            return x.kind == y.kind && x.prev_kind == y.prev_kind &&
+                   x.line == y.line && x.index == y.index;
+        });
+    }
+
+    // Counts node kinds from any thread.
+    struct KindCounter : CSTVisitor {
+        std::array<std::atomic<int>, 64> counts{};
+        std::atomic<int> visits{0};
+
+        void on_node(const CSTNode &node) override {
+            counts[static_cast<std::size_t>(node.kind)].fetch_add(1, std::memory_order_relaxed);
+            visits.fetch_add(1, std::memory_order_relaxed);
+        }
+        [[nodiscard]] bool concurrent() const noexcept override { return true; }
+    };
+}
+
+int main() {
+    "parallel CST equals sequential CST"_test = [] {
+        given("A file of many lines") = [] {
+            const std::string src = sample(100);
+            FortranTokenizer tz(src);
+            const auto tokens = tz.tokenize();
+            const UnwrappedLineParser parser(tokens);
+            const auto lines = parser.parse();
+            const auto expected = build_cst(lines);
+
+            WorkStealingPool pool(4);
+
+            for (std::size_t chunk : {1ul, 7ul, 64ul, 100000ul}) {
+                when("It is classified in chunks of " + std::to_string(chunk) + " lines") = [&] {
+                    then("Kinds, prev_kinds and line pointers match.") = [&] {
+                        expect(same_nodes(build_cst_parallel(lines, pool, nullptr, chunk), expected));
+
+                        const auto table = parser.parse_ranges();
+                        const auto ranged = build_cst_parallel(table, pool, nullptr, chunk);
+                        expect(same_nodes(ranged, build_cst(table)));
+                    };
+                };
+            }
+        };
+    };
+
+    "prev_kind carries across chunks of blank lines"_test = [] {
+        const auto tokens = FortranTokenizer("program p\n\n\n\n\n\nx = 1\n").tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse();
+        WorkStealingPool pool(2);
+
+        const auto cst = build_cst_parallel(lines, pool, nullptr, 2);
+        expect(same_nodes(cst, build_cst(lines)));
+        expect(cst[6].prev_kind == NodeKind::Program);
+    };
+
+    "sequential visitors see nodes in order"_test = [] {
+        const std::string src = sample(20);
+        const auto tokens = FortranTokenizer(src).tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse();
+        WorkStealingPool pool(4);
+
+        BlockTreeBuilder sequential;
+        build_cst(lines, &sequential);
+        BlockTreeBuilder parallel;
+        build_cst_parallel(lines, pool, &parallel, 5);
+
+        expect(parallel.root->begin_node->kind == sequential.root->begin_node->kind);
+        expect(parallel.root->children.size() == sequential.root->children.size());
+    };
+
+    "concurrent visitors visit every node once"_test = [] {
+        const std::string src = sample(50);
+        const auto tokens = FortranTokenizer(src).tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse();
+        WorkStealingPool pool(4);
+
+        KindCounter counter;
+        const auto cst = build_cst_parallel(lines, pool, &counter, 3);
+
+        expect(counter.visits.load() == static_cast<int>(cst.size()));
+        expect(counter.counts[static_cast<std::size_t>(NodeKind::Subroutine)].load() == 50_i);
+        expect(counter.counts[static_cast<std::size_t>(NodeKind::EndIf)].load() == 50_i);
+    };
+}
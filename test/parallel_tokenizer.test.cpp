@@ -0,0 +1,91 @@
+#include <ut.hpp>
+#include "parallel_tokenizer.hpp"
+#include <string>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    std::string tricky_source(int repeats) {
+        std::string text;
+        for (int i = 0; i < repeats; ++i) {
+            text += "subroutine s" + std::to_string(i) + "(a, &\n";
+            text += "    b)\n";
+            text += "  x = - 3 + f(-2)\n";
+            text += "-4\n";
+            text += "  print *, 'it''s & ! not a comment', \"two\n";
+            text += "lines\"\n";
+            text += "  ! a 'quote in a comment\n";
+            text += "  y = 1.5e-3_dp * x & ! trailing note\n";
+            text += "      + 2\n";
+            text += "end subroutine s" + std::to_string(i) + "\n";
+        }
+        return text;
+    }
+
+    bool same_tokens(const std::vector<Token> &a, const std::vector<Token> &b) {
+        return std::ranges::equal(a, b, [](const Token &x, const Token &y) {
+            return x.kind == y.kind && x.text == y.text && x.line == y.line &&
+                   x.column == y.column && x.keyword == y.keyword && x.symbol == y.symbol;
+        });
+    }
+}
+
+int main() {
+    "split points are safe line starts"_test = [] {
+        const std::string src = "a = 'x\ny'\nb = 1 &\n  + 2\nc = 3\n";
+        const auto cuts = split_points(src, 4);
+
+        expect(cuts.front() == 0_ul);
+        expect(cuts.back() == src.size());
+        for (std::size_t i = 1; i + 1 < cuts.size(); ++i) {
+            expect(src[cuts[i] - 1] == '\n');
+            expect(cuts[i] != 7_ul);  // inside the string
+            expect(cuts[i] != 18_ul); // after the '&'
+        }
+        expect(std::ranges::is_sorted(cuts));
+    };
+
+    "parallel tokens equal sequential tokens"_test = [] {
+        given("A source with strings, continuations and signed literals") = [] {
+            const std::string src = tricky_source(200);
+            const auto expected = FortranTokenizer(src).tokenize();
+
+            WorkStealingPool pool(4);
+
+            for (std::size_t chunk : {16ul, 100ul, 1000ul, 10000ul}) {
+                when("It is cut into chunks of " + std::to_string(chunk) + " bytes") = [&] {
+                    const auto tokens = tokenize_parallel(src, pool, nullptr, chunk);
+
+                    then("The stream is identical, line numbers included.") = [&] {
+                        expect(tokens.size() == expected.size());
+                        expect(same_tokens(tokens, expected));
+                    };
+                };
+            }
+        };
+    };
+
+    "symbols are interned the same way"_test = [] {
+        const std::string src = tricky_source(50);
+        SymbolTable seq_symbols;
+        SymbolTable par_symbols;
+        const auto expected = FortranTokenizer(src, &seq_symbols).tokenize();
+
+        WorkStealingPool pool(3);
+        const auto tokens = tokenize_parallel(src, pool, &par_symbols, 64);
+
+        expect(tokens.size() == expected.size());
+        for (std::size_t i = 0; i < tokens.size(); ++i) {
+            if (tokens[i].kind != TokenKind::Identifier) continue;
+            expect(par_symbols.name(tokens[i].symbol) == seq_symbols.name(expected[i].symbol));
+        }
+    };
+
+    "small sources are tokenized directly"_test = [] {
+        WorkStealingPool pool(2);
+        const std::string src = "x = 1\n";
+        expect(same_tokens(tokenize_parallel(src, pool), FortranTokenizer(src).tokenize()));
+        expect(tokenize_parallel("", pool).size() == 1_ul);
+    };
+}
@@ -0,0 +1,104 @@
+#include <ut.hpp>
+#include "block_tree.hpp"
+#include "formatter.hpp"
+#include "profile.hpp"
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    auto &profiler = Profiler::global();
+
+    "scopes record stage, items and time"_test = [&] {
+        profiler.clear();
+        {
+            ProfileScope scope("tokenize", "tokens");
+            scope.items(42);
+            std::vector<int> v(1000);
+            expect(v.size() == 1000_u);
+        }
+
+        const auto events = profiler.events();
+        expect(events.size() == 1_u);
+        expect(events[0].stage == "tokenize");
+        expect(events[0].unit == "tokens");
+        expect(events[0].items == 42_u);
+        expect(events[0].start_ns + events[0].duration_ns <= profiler.now_ns());
+#ifdef FORMAT_ENABLE_PROFILING
+        expect(events[0].allocations >= 1_u);
+        expect(events[0].alloc_bytes >= 4000_u);
+#else
+        expect(events[0].allocations == 0_u);
+#endif
+    };
+
+    "threads get their own index"_test = [&] {
+        profiler.clear();
+        std::jthread([] { ProfileScope scope("parse", "lines"); }).join();
+        { ProfileScope scope("parse", "lines"); }
+
+        const auto events = profiler.events();
+        expect(events.size() == 2_u);
+        expect(events[0].thread != events[1].thread);
+        expect(events[1].thread == Profiler::thread_index());
+    };
+
+    "json and trace exports"_test = [&] {
+        profiler.clear();
+        expect(profiler.to_json() == "{\n  \"events\": [],\n  \"stages\": {}\n}\n");
+
+        for (int i = 0; i < 2; ++i) {
+            ProfileScope scope("build_cst", "nodes");
+            scope.items(10);
+        }
+
+        const auto json = profiler.to_json();
+        expect(json.contains("\"stage\": \"build_cst\""));
+        expect(json.contains("\"build_cst\": {\"calls\": 2,"));
+        expect(json.contains("\"items\": 20, \"unit\": \"nodes\""));
+
+        const auto trace = profiler.to_chrome_trace();
+        expect(trace.starts_with("{\"traceEvents\": ["));
+        expect(trace.contains("\"name\": \"build_cst\", \"cat\": \"format\", \"ph\": \"X\""));
+        expect(trace.contains("\"nodes\": 10"));
+        expect(std::ranges::count(trace, '{') == std::ranges::count(trace, '}'));
+    };
+
+    "the pipeline reports its stages only when enabled"_test = [&] {
+        given("A file formatted and given a block tree") = [&] {
+            profiler.clear();
+            const std::string src = "module m\ncontains\nsubroutine s()\nx=1\nend subroutine s\nend module m\n";
+            FortranTokenizer tz(src);
+            const auto tokens = tz.tokenize();
+            const auto lines = UnwrappedLineParser(tokens).parse_ranges();
+            const auto cst = build_cst(lines);
+            const auto tree = FlatBlockTreeBuilder::build(cst);
+            expect(!FortranFormatter{}.format(src).empty());
+
+            const auto events = profiler.events();
+            const auto find = [&](std::string_view stage) {
+                return std::ranges::find(events, stage, &ProfileEvent::stage);
+            };
+
+#ifdef FORMAT_ENABLE_PROFILING
+            then("Every stage is there, with its item count.") = [&] {
+                expect(find("tokenize") != events.end() && find("tokenize")->items == tokens.size());
+                expect(find("parse") != events.end() && find("parse")->items == lines.size());
+                expect(find("build_cst") != events.end() && find("build_cst")->items == cst.size());
+                expect(find("block_tree") != events.end() && find("block_tree")->items == tree.size());
+                expect(find("emit") != events.end());
+                expect(find("tokenize")->allocations >= 1_u);
+            };
+#else
+            then("Nothing is recorded.") = [&] {
+                expect(events.empty());
+                expect(find("tokenize") == events.end());
+            };
+#endif
+        };
+    };
+}
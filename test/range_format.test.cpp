@@ -0,0 +1,97 @@
+#include <ut.hpp>
+#include "range_format.hpp"
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    const std::string src =
+        "module m\n"                    //  1
+        "integer::a\n"                  //  2
+        "contains\n"                    //  3
+        "subroutine s(x)\n"             //  4
+        "real::x\n"                     //  5
+        "if(x>0) then\n"                //  6
+        "x=x+1\n"                       //  7
+        "end if\n"                      //  8
+        "end subroutine s\n"            //  9
+        "subroutine t()\n"              // 10
+        "call s( 1.0 )\n"               // 11
+        "end subroutine t\n"            // 12
+        "end module m\n";               // 13
+
+    const auto format_lines = [&](std::vector<SourceLineRange> ranges) {
+        return apply_replacements(src, format_ranges(src, ranges));
+    };
+
+    "a hunk expands to its enclosing block"_test = [&] {
+        given("A change on a line inside an if construct") = [&] {
+            const auto replacements = format_ranges(src, std::vector<SourceLineRange>{{7, 7}});
+
+            then("Only the construct is formatted, at the depth of its ancestors.") = [&] {
+                expect(replacements.size() == 1_u);
+                expect(apply_replacements(src, replacements) ==
+                    "module m\n"
+                    "integer::a\n"
+                    "contains\n"
+                    "subroutine s(x)\n"
+                    "real::x\n"
+                    "    if (x > 0) then\n"
+                    "      x = x+1\n"
+                    "    end if\n"
+                    "end subroutine s\n"
+                    "subroutine t()\n"
+                    "call s( 1.0 )\n"
+                    "end subroutine t\n"
+                    "end module m\n");
+            };
+        };
+    };
+
+    "replacements cover only changed lines"_test = [&] {
+        const std::string tidy =
+            "subroutine s()\n"
+            "  x = 1\n"
+            "  y=2\n"
+            "  z = 3\n"
+            "end subroutine s\n";
+
+        const auto replacements = format_ranges(tidy, std::vector<SourceLineRange>{{3, 3}});
+        expect(replacements.size() == 1_u);
+        expect(replacements[0].offset == tidy.find("  y=2"));
+        expect(replacements[0].length == std::string("  y=2\n").size());
+        expect(replacements[0].text == "  y = 2\n");
+    };
+
+    "overlapping and nested ranges merge"_test = [&] {
+        const auto once = format_lines({{11, 11}, {7, 7}, {5, 6}, {11, 12}});
+        expect(once.contains("  subroutine t()\n    call s(1.0)\n  end subroutine t\n"));
+        expect(once.contains("  subroutine s(x)\n    real :: x\n"));
+        expect(once.contains("integer::a\n"));
+    };
+
+    "formatting every line matches formatting the file"_test = [&] {
+        expect(format_lines({{1, 13}}) == FortranFormatter{}.format(src));
+        expect(format_lines({{1, 100}}) == FortranFormatter{}.format(src));
+    };
+
+    "already formatted ranges yield nothing"_test = [&] {
+        const auto formatted = FortranFormatter{}.format(src);
+        expect(format_ranges(formatted, std::vector<SourceLineRange>{{1, 13}}).empty());
+    };
+
+    "blank lines before a range count toward the limit"_test = [&] {
+        // line 3 is outside the range and stays; line 4 is one blank too many
+        const std::string blanks = "x = 1\n\n\n\ny = 2\n";
+        expect(apply_replacements(blanks, format_ranges(blanks, std::vector<SourceLineRange>{{4, 5}})) ==
+               "x = 1\n\n\ny = 2\n");
+    };
+
+    "empty and out of range requests"_test = [&] {
+        expect(format_ranges(src, std::vector<SourceLineRange>{}).empty());
+        expect(format_ranges(src, std::vector<SourceLineRange>{{50, 60}}).empty());
+        expect(format_ranges(src, std::vector<SourceLineRange>{{5, 4}}).empty());
+    };
+}
@@ -0,0 +1,87 @@
+#include <ut.hpp>
+#include "scan.hpp"
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    // Reference definitions, one byte at a time.
+    std::size_t ref_blanks(std::string_view s) {
+        std::size_t i = 0;
+        while (i < s.size() && (s[i] == ' ' || s[i] == '\t')) ++i;
+        return i;
+    }
+
+    std::size_t ref_line_end(std::string_view s) {
+        std::size_t i = 0;
+        while (i < s.size() && s[i] != '\n' && s[i] != '\0') ++i;
+        return i;
+    }
+
+    std::size_t ref_newline(std::string_view s) {
+        std::size_t i = 0;
+        while (i < s.size() && s[i] != '\n') ++i;
+        return i;
+    }
+
+    std::size_t ref_identifier(std::string_view s) {
+        std::size_t i = 0;
+        while (i < s.size() && (std::isalnum(static_cast<unsigned char>(s[i])) || s[i] == '_')) ++i;
+        return i;
+    }
+
+    // Runs of a single character class followed by a random stopper, at
+    // every length around the 16/32-byte block boundaries.
+    std::vector<std::string> make_inputs() {
+        std::mt19937 rng(1234);
+        const std::string blank = " \t";
+        const std::string ident = "abcxyzABCXYZ019_";
+        const std::string body = "abc !'\"&()*+-=%\t";
+        const std::string stop("\n\0x+.(!@[`{~\x80\xff", 14);
+
+        std::vector<std::string> inputs;
+        for (std::size_t len = 0; len < 100; ++len) {
+            for (const std::string *cls : {&blank, &ident, &body}) {
+                std::string s;
+                for (std::size_t i = 0; i < len; ++i) s.push_back((*cls)[rng() % cls->size()]);
+                inputs.push_back(s);
+                for (char c : stop) inputs.push_back(s + c + "tail  ");
+            }
+        }
+        return inputs;
+    }
+}
+
+int main() {
+    const auto inputs = make_inputs();
+
+    for (ScanIsa isa : {ScanIsa::Scalar, ScanIsa::SSE2, ScanIsa::AVX2}) {
+        if (!force_scan_isa(isa)) continue;
+
+        test("scanners match the byte-wise definition (isa " + std::to_string(static_cast<int>(isa)) + ")") = [&] {
+            expect(active_scan_isa() == isa);
+            for (const auto &s : inputs) {
+                expect(count_blanks(s.data(), s.size()) == ref_blanks(s));
+                expect(count_until_line_end(s.data(), s.size()) == ref_line_end(s));
+                expect(count_until_newline(s.data(), s.size()) == ref_newline(s));
+                expect(count_identifier_chars(s.data(), s.size()) == ref_identifier(s));
+            }
+        };
+
+        test("scanners never look past n (isa " + std::to_string(static_cast<int>(isa)) + ")") = [] {
+            const std::string s(64, ' ');
+            expect(count_blanks(s.data(), 0) == 0_u);
+            expect(count_blanks(s.data(), 17) == 17_u);
+            expect(count_blanks(s.data(), 33) == 33_u);
+            expect(count_until_line_end(s.data(), 40) == 40_u);
+            expect(count_until_newline(s.data(), 40) == 40_u);
+        };
+    }
+
+    "scalar is always available"_test = [] {
+        expect(force_scan_isa(ScanIsa::Scalar));
+    };
+}
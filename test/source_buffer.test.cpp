@@ -0,0 +1,90 @@
+#include <ut.hpp>
+#include "source_buffer.hpp"
+#include "tokenizer.hpp"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <thread>
+#include <unistd.h>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    std::filesystem::path write_temp(const std::string &name, const std::string &text) {
+        const auto path = std::filesystem::temp_directory_path() / name;
+        std::ofstream(path, std::ios::binary) << text;
+        return path;
+    }
+}
+
+int main() {
+    "regular files are mapped"_test = [] {
+        const std::string text = "program main\n  x = 1\nend program main\n";
+        const auto path = write_temp("format_source_buffer_test.f90", text);
+
+        const auto src = SourceBuffer::from_file(path);
+        expect(src.is_mapped());
+        expect(src.view() == text);
+
+        FortranTokenizer tz(src);
+        const auto tokens = tz.tokenize();
+        expect(tokens.front().text == "program");
+        expect(src.owns(tokens.front().text));
+
+        std::filesystem::remove(path);
+    };
+
+    "empty files are read, not mapped"_test = [] {
+        const auto path = write_temp("format_source_buffer_empty.f90", "");
+
+        const auto src = SourceBuffer::from_file(path);
+        expect(!src.is_mapped());
+        expect(src.size() == 0_u);
+
+        std::filesystem::remove(path);
+    };
+
+    "pipes fall back to buffered reads"_test = [] {
+        int fds[2];
+        expect((::pipe(fds) == 0) >> fatal);
+
+        std::string text;
+        for (int i = 0; i < 20000; ++i) text += "x = " + std::to_string(i) + "\n";
+
+        std::thread writer([&] {
+            std::size_t done = 0;
+            while (done < text.size()) {
+                const auto n = ::write(fds[1], text.data() + done, text.size() - done);
+                if (n <= 0) break;
+                done += static_cast<std::size_t>(n);
+            }
+            ::close(fds[1]);
+        });
+
+        const auto src = SourceBuffer::from_descriptor(fds[0]);
+        writer.join();
+        ::close(fds[0]);
+
+        expect(!src.is_mapped());
+        expect(src.view() == text);
+    };
+
+    "mapped buffers keep their address when moved"_test = [] {
+        const auto path = write_temp("format_source_buffer_move.f90", "module m\nend module m\n");
+
+        auto src = SourceBuffer::from_file(path);
+        const char *data = src.data();
+        SourceBuffer moved(std::move(src));
+        expect(moved.data() == data);
+        expect(moved.view() == "module m\nend module m\n");
+
+        std::filesystem::remove(path);
+    };
+
+    "missing files throw"_test = [] {
+        expect(throws<std::system_error>([] {
+            (void) SourceBuffer::from_file("/nonexistent/format_source_buffer.f90");
+        }));
+    };
+}
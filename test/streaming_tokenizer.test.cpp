@@ -0,0 +1,110 @@
+#include <ut.hpp>
+#include "streaming_tokenizer.hpp"
+#include "tokenizer.hpp"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    struct OwnedToken {
+        TokenKind kind;
+        std::string text;
+        int line;
+        int column;
+
+        bool operator==(const OwnedToken &) const = default;
+    };
+
+    std::vector<OwnedToken> own(std::span<const Token> tokens) {
+        std::vector<OwnedToken> out;
+        for (const auto &t : tokens) out.push_back({t.kind, std::string(t.text), t.line, t.column});
+        return out;
+    }
+
+    std::vector<OwnedToken> tokenize_whole(const std::string &src) {
+        FortranTokenizer tz(src);
+        return own(tz.tokenize());
+    }
+
+    // Feeds src in pieces of chunk_size bytes, draining after each feed.
+    std::vector<OwnedToken> tokenize_streamed(const std::string &src, std::size_t chunk_size) {
+        StreamingTokenizer st;
+        std::vector<OwnedToken> out;
+        auto drain = [&] {
+            for (auto batch = st.next(); !batch.empty(); batch = st.next()) {
+                auto owned = own(batch);
+                out.insert(out.end(), owned.begin(), owned.end());
+            }
+        };
+
+        for (std::size_t pos = 0; pos < src.size(); pos += chunk_size) {
+            st.feed(std::string_view(src).substr(pos, chunk_size));
+            drain();
+        }
+        st.finish();
+        drain();
+        expect(st.done());
+        return out;
+    }
+
+    const std::string sample =
+        "program main ! a 'quoted' comment\n"
+        "  implicit none\n"
+        "  integer :: i, j\n"
+        "  character(len=*), parameter :: s = 'it''s a \"string\" ! not a comment'\n"
+        "  x = - 3 + foo(a, &\n"
+        "      & b, -4) &   \n"
+        "      ** 2\n"
+        "\n"
+        "  y = 'spans\n"
+        "two lines'\n"
+        "-1\n"
+        "  do i = 1, 10\n"
+        "     print *, i + 1 ! & not a continuation\n"
+        "  end do\n"
+        "end program main";
+}
+
+int main() {
+    "streaming matches whole-input tokenization for every chunk size"_test = [] {
+        const auto expected = tokenize_whole(sample);
+        for (std::size_t chunk = 1; chunk <= sample.size() + 1; ++chunk) {
+            const auto streamed = tokenize_streamed(sample, chunk);
+            expect(streamed.size() == expected.size()) << "chunk size" << chunk;
+            expect(std::ranges::equal(streamed, expected)) << "chunk size" << chunk;
+        }
+    };
+
+    "batches hold complete logical lines"_test = [] {
+        given("a continued statement fed in one chunk") = [] {
+            StreamingTokenizer st;
+            st.feed("x = a &\n  + b\ny = 1\nz");
+            const auto batch = st.next();
+
+            then("the batch ends after the continued statement and the next line") = [&] {
+                expect(batch.size() == 12_u);
+                expect(batch.back().kind == TokenKind::Newline);
+                expect(batch.back().line == 3_i);
+            };
+
+            then("the partial last line waits for more input") = [&] {
+                expect(st.next().empty());
+                expect(!st.done());
+            };
+        };
+    };
+
+    "empty input yields only end of file"_test = [] {
+        StreamingTokenizer st;
+        expect(st.next().empty());
+        st.finish();
+        const auto batch = st.next();
+        expect(batch.size() == 1_u);
+        expect(batch.front().kind == TokenKind::EndOfFile);
+        expect(st.done());
+        expect(st.next().empty());
+    };
+}
@@ -0,0 +1,64 @@
+#include <ut.hpp>
+#include "symbols.hpp"
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    "SymbolTable"_test = [] {
+        given("an empty symbol table") = [] {
+            SymbolTable table;
+
+            then("it has no symbols") = [&] {
+                expect(table.size() == 0_u);
+                expect(table.name(Symbol{}).empty());
+            };
+
+            then("the empty name has no symbol") = [&] {
+                expect(!table.intern(""));
+            };
+
+            when("names are interned") = [&] {
+                const Symbol a = table.intern("Alpha");
+                const Symbol b = table.intern("alpha");
+                const Symbol c = table.intern("beta");
+
+                then("case variants share one symbol") = [&] {
+                    expect(a == b);
+                    expect(a != c);
+                    expect(table.size() == 2_u);
+                };
+
+                then("the stored spelling is folded to lower case") = [&] {
+                    expect(table.name(a) == "alpha");
+                    expect(table.name(c) == "beta");
+                };
+            };
+        };
+    };
+
+    "concurrent interning agrees on symbols"_test = [] {
+        SymbolTable table;
+        constexpr int num_threads = 4;
+        constexpr int num_names = 1000;
+        std::vector<std::vector<Symbol>> seen(num_threads);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t] {
+                for (int i = 0; i < num_names; ++i)
+                    seen[t].push_back(table.intern("name_" + std::to_string(i)));
+            });
+        }
+        for (auto &th : threads) th.join();
+
+        expect(table.size() == std::size_t{num_names});
+        for (int t = 1; t < num_threads; ++t)
+            expect(std::ranges::equal(seen[t], seen[0]));
+        expect(table.name(seen[0][42]) == "name_42");
+    };
+}
@@ -0,0 +1,82 @@
+#include <ut.hpp>
+#include "thread_pool.hpp"
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+int main() {
+    "every task runs exactly once"_test = [] {
+        given("A pool with four workers and many tasks") = [] {
+            WorkStealingPool pool(4);
+            std::vector<uint32_t> order(5000);
+            std::iota(order.begin(), order.end(), 0u);
+            std::vector<std::atomic<int>> runs(order.size());
+            std::vector<std::atomic<int>> per_worker(pool.size());
+
+            pool.run(order, [&](unsigned worker, uint32_t id) {
+                runs[id].fetch_add(1);
+                per_worker[worker].fetch_add(1);
+            });
+
+            then("Each id was seen once and every worker index is valid.") = [&] {
+                expect(std::ranges::all_of(runs, [](const auto &r) { return r.load() == 1; }));
+                int total = 0;
+                for (const auto &n : per_worker) total += n.load();
+                expect(total == 5000_i);
+            };
+        };
+    };
+
+    "the pool can run several jobs"_test = [] {
+        WorkStealingPool pool(3);
+        for (uint32_t job = 0; job < 20; ++job) {
+            std::vector<uint32_t> order(job + 1);
+            std::iota(order.begin(), order.end(), 0u);
+            std::atomic<uint32_t> sum{0};
+            pool.run(order, [&](unsigned, uint32_t id) { sum += id + 1; });
+            expect(sum.load() == (job + 1) * (job + 2) / 2) << "job" << job;
+        }
+    };
+
+    "idle workers steal from a busy one"_test = [] {
+        // One worker is dealt a long task first; the quick tasks dealt
+        // to it behind the long one are taken by the others.
+        WorkStealingPool pool(2);
+        std::vector<uint32_t> order{0, 1, 2, 3, 4, 5, 6, 7};
+        std::vector<unsigned> ran_on(order.size());
+        std::atomic<bool> release{false};
+
+        pool.run(order, [&](unsigned worker, uint32_t id) {
+            ran_on[id] = worker;
+            if (id == 0) {
+                while (!release.load()) std::this_thread::yield();
+            } else if (id == 7) {
+                release = true;
+            }
+        });
+
+        // Worker 0 was dealt 0, 2, 4, 6 and is stuck on 0 until worker 1
+        // reaches 7, so 2, 4 and 6 must have been stolen.
+        expect(ran_on[2] == ran_on[1]);
+        expect(ran_on[4] == ran_on[1]);
+        expect(ran_on[6] == ran_on[1]);
+    };
+
+    "task exceptions reach the caller"_test = [] {
+        WorkStealingPool pool(2);
+        std::vector<uint32_t> order{0, 1, 2, 3};
+        std::atomic<int> runs{0};
+
+        expect(throws<std::runtime_error>([&] {
+            pool.run(order, [&](unsigned, uint32_t id) {
+                ++runs;
+                if (id == 2) throw std::runtime_error("task failed");
+            });
+        }));
+        expect(runs.load() == 4_i);
+    };
+}
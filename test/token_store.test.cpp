@@ -0,0 +1,153 @@
+#include <ut.hpp>
+#include "token_store.hpp"
+#include "tokenizer.hpp"
+#include "unwrapped_line.hpp"
+#include "cst.hpp"
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using namespace boost::ut::bdd;
+
+namespace {
+    struct SpanLine {
+        TokenSpan tokens;
+    };
+
+    const std::string sample =
+        "program main\n"
+        "  use iso_c_binding, only: c_ptr\n"
+        "  integer :: i\n"
+        "  type, extends(base) :: child\n"
+        "  end type\n"
+        "  type(child) :: c\n"
+        "  x = - 3 + y%z\n"
+        "  if (x > 0) then\n"
+        "    call foo(x, 'str')\n"
+        "  else if (x < -1) then\n"
+        "  end if\n"
+        "  do i = 1, 10\n"
+        "  enddo\n"
+        "  ! comment\n"
+        "end program main\n";
+}
+
+int main() {
+    "TokenStore"_test = [] {
+        given("a store filled by the tokenizer") = [] {
+            const auto store = TokenStore::from_source(sample);
+            FortranTokenizer tz(sample);
+            const auto tokens = tz.tokenize();
+
+            then("every column round-trips the token stream") = [&] {
+                expect(store.size() == tokens.size());
+                for (std::size_t i = 0; i < tokens.size(); ++i) {
+                    const Token t = store[i];
+                    expect(t.kind == tokens[i].kind);
+                    expect(t.text == tokens[i].text);
+                    expect(t.line == tokens[i].line);
+                    expect(t.column == tokens[i].column);
+                    expect(t.keyword == tokens[i].keyword);
+                }
+            };
+
+            then("source spellings are offsets into the source") = [&] {
+                expect(store.source().data() == sample.data());
+                expect(store.text(0).data() == sample.data());
+            };
+
+            then("detached spellings come from the side table") = [&] {
+                const auto it = std::ranges::find_if(store.all(), [](const Token &t) { return t.text == "-3"; });
+                expect(it != store.all().end());
+            };
+        };
+    };
+
+    "lazy positions"_test = [] {
+        given("a store that keeps offsets only") = [] {
+            const auto stored = TokenStore::from_source(sample);
+            const auto lazy = TokenStore::from_source(sample, nullptr, TokenPositions::Lazy);
+
+            then("lines and columns match the stored ones") = [&] {
+                expect((lazy.size() == stored.size()) >> fatal);
+                for (std::size_t i = 0; i < lazy.size(); ++i) {
+                    expect(lazy.line(i) == stored.line(i)) << i;
+                    expect(lazy.column(i) == stored.column(i)) << i;
+                    expect(lazy[i].text == stored[i].text) << i;
+                }
+            };
+
+            then("the detached literal keeps the tokenizer's position") = [&] {
+                const auto it = std::ranges::find_if(lazy.all(), [](const Token &t) { return t.text == "-3"; });
+                expect((it != lazy.all().end()) >> fatal);
+                expect((*it).line == 7_i);
+                expect((*it).column == 7_i);
+            };
+
+            then("end of file sits after the last newline") = [&] {
+                expect(lazy.kind(lazy.size() - 1) == TokenKind::EndOfFile);
+                expect(lazy.line(lazy.size() - 1) == 16_i);
+                expect(lazy.column(lazy.size() - 1) == 1_i);
+            };
+        };
+    };
+
+    "TokenSpan"_test = [] {
+        given("a span over one line") = [] {
+            const std::string src = "use iso_c_binding, only: c_ptr\n";
+            const auto store = TokenStore::from_source(src);
+            const TokenSpan line = store.slice(0, store.size() - 1); // drop EndOfFile
+
+            then("it answers the Tokens queries") = [&] {
+                expect(line.size() == 7_u);
+                expect(line.first_token_is("use"));
+                expect(line.first_token_is(KeywordId::Use));
+                expect(!line.first_token_is("only"));
+                expect(line.first_token_is_any(std::array<std::string_view, 2>{"call", "use"}));
+                expect(line.contains_token("only"));
+                expect(line.contains_token(KeywordId::Use));
+                expect(!line.contains_token(KeywordId::Call));
+                expect(line.contains_kind(TokenKind::Colon));
+                expect(!line.contains_kind(TokenKind::LParen));
+                expect(line.contains_token_sequence(std::array<std::string_view, 2>{"only", ":"}));
+                expect(!line.contains_token_sequence(std::array<std::string_view, 2>{":", "only"}));
+                expect(line.back().kind == TokenKind::Newline);
+            };
+
+            then("kinds stream as a packed byte column") = [&] {
+                expect(line.kinds().size() == line.size());
+                expect(line.kinds()[0] == TokenKind::Keyword);
+            };
+        };
+
+        given("an empty span") = [] {
+            const TokenSpan line;
+            then("queries are false") = [&] {
+                expect(line.empty());
+                expect(!line.first_token_is("x"));
+                expect(!line.contains_token(KeywordId::End));
+                expect(!line.contains_kind(TokenKind::Newline));
+            };
+        };
+    };
+
+    "classify over spans matches classify over unwrapped lines"_test = [] {
+        const auto store = TokenStore::from_source(sample);
+        FortranTokenizer tz(sample);
+        const auto tokens = tz.tokenize();
+        const auto lines = UnwrappedLineParser(tokens).parse();
+
+        std::vector<SpanLine> span_lines;
+        std::size_t begin = 0;
+        for (std::size_t i = 0; i < store.size(); ++i) {
+            if (store.kind(i) == TokenKind::Newline) {
+                span_lines.push_back({store.slice(begin, i + 1)});
+                begin = i + 1;
+            }
+        }
+
+        expect((span_lines.size() + 1 == lines.size()) >> fatal);
+        for (std::size_t i = 0; i < span_lines.size(); ++i)
+            expect(classify(span_lines[i]) == classify(lines[i])) << "line" << i;
+    };
+}
@@ -105,6 +105,7 @@ int main() {
         const std::vector<TokenTestCase> test_cases = {
             {"x = 1 + 2", "+", TokenKind::Operator},
              {"x = 1 - 2", "-",  TokenKind::Operator},
+            {"a = f(x) - 1", "-", TokenKind::Operator}, {"n = size(x)-1", "-", TokenKind::Operator},
             {"x = 1 * 2", "*", TokenKind::Operator}, {"x = 1 / 2", "/", TokenKind::Operator},
             {"x = 1", "=", TokenKind::Operator}, {"x = 1 ** 2", "**", TokenKind::Operator},
         };
@@ -116,6 +117,35 @@ int main() {
         }
     };
 
+    "two-character operators"_test = [] {
+        const auto texts = [](std::string_view src) {
+            FortranTokenizer tz(src);
+            std::vector<std::string_view> out;
+            for (const auto &t : tz.tokenize())
+                if (t.kind != TokenKind::EndOfFile) out.push_back(t.text);
+            return out;
+        };
+
+        expect(texts("a>=b<=c/=d==e**f") ==
+               std::vector<std::string_view>{"a", ">=", "b", "<=", "c", "/=", "d", "==", "e", "**", "f"});
+        expect(texts("p=>q") == std::vector<std::string_view>{"p", "=", ">", "q"});
+        expect(texts("a//b") == std::vector<std::string_view>{"a", "/", "/", "b"});
+        expect(texts("x***=") == std::vector<std::string_view>{"x", "**", "*", "="});
+        expect(texts("x=") == std::vector<std::string_view>{"x", "="});
+        expect(texts("x*") == std::vector<std::string_view>{"x", "*"});
+    };
+
+    "character table agrees with the helpers"_test = [] {
+        for (int b = 0; b < 256; ++b) {
+            const char c = static_cast<char>(b);
+            const CharClass cls = char_info(c).cls;
+            expect((cls == CharClass::Alpha) == is_alpha(c)) << b;
+            expect((cls == CharClass::Digit) == is_digit(c)) << b;
+            expect((cls == CharClass::Blank) == is_space(c)) << b;
+            expect((cls == CharClass::End) == (c == '\0')) << b;
+        }
+    };
+
 
     //
     // ------------------------------------------------------------
@@ -280,4 +310,79 @@ end program
         expect(exists(t, has(TokenKind::Number, "1")));
         expect(count_tokens(t, has(TokenKind::Keyword, "end")) >= 2);
     };
+
+    //
+    // ------------------------------------------------------------
+    // Zero-copy Token Text
+    // ------------------------------------------------------------
+    //
+    "token text views the source buffer"_test = [] {
+        const SourceBuffer src("x = a(1) ** 2 &\n  + b%c ! note\ny=-4\n");
+        FortranTokenizer tz(src);
+        auto t = tz.tokenize();
+
+        for (const auto &tok: t) {
+            if (tok.kind == TokenKind::EndOfFile) continue;
+            expect(src.owns(tok.text)) << tok.text;
+        }
+        expect(exists(t, has(TokenKind::Number, "-4")));
+    };
+
+    "source buffer keeps views valid across moves"_test = [] {
+        SourceBuffer src("program main\n");
+        FortranTokenizer tz(src);
+        auto t = tz.tokenize();
+
+        SourceBuffer moved(std::move(src));
+        expect(moved.owns(t.front().text));
+        expect(t.front().text == "program");
+    };
+
+    "detached signed literal spelling is interned"_test = [] {
+        std::string a = "x = - 3";
+        std::string b = "y = -   3";
+        FortranTokenizer ta(a), tb(b);
+        auto t1 = ta.tokenize();
+        auto t2 = tb.tokenize();
+
+        const auto n1 = std::ranges::find_if(t1, has(TokenKind::Number, "-3"));
+        const auto n2 = std::ranges::find_if(t2, has(TokenKind::Number, "-3"));
+        expect(n1 != t1.end() && n2 != t2.end());
+        expect(n1->text.data() == n2->text.data());
+    };
+
+    //
+    // ------------------------------------------------------------
+    // Keyword IDs and Symbols
+    // ------------------------------------------------------------
+    //
+    "keywords carry their id"_test = [] {
+        std::string src = "End Subroutine foo";
+        FortranTokenizer tz(src);
+        auto t = tz.tokenize();
+
+        expect(t[0].keyword == KeywordId::End);
+        expect(t[1].keyword == KeywordId::Subroutine);
+        expect(t[2].keyword == KeywordId::Unknown);
+    };
+
+    "identifiers are interned case-insensitively"_test = [] {
+        SymbolTable symbols;
+        std::string src = "foo = Foo + bar";
+        FortranTokenizer tz(src, &symbols);
+        auto t = tz.tokenize();
+
+        expect(bool(t[0].symbol));
+        expect(t[0].symbol == t[2].symbol);
+        expect(t[0].symbol != t[4].symbol);
+        expect(symbols.name(t[2].symbol) == "foo");
+    };
+
+    "identifiers have no symbol without a table"_test = [] {
+        std::string src = "foo";
+        FortranTokenizer tz(src);
+        auto t = tz.tokenize();
+
+        expect(!t[0].symbol);
+    };
 }
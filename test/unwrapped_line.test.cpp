@@ -83,4 +83,47 @@ int main() {
         const auto lines = parser.parse();
         expect(lines.size() == 1_i);
     };
+
+    "range lines match copied lines"_test = [] {
+        const std::array<std::string_view, 6> sources{
+            "x=1\ny=2\n",
+            "subroutine foo(& \n a, b)\n",
+            "subroutine foo(&\n    a, b &\n)\nend subroutine\n",
+            "x = 1   \n  call f(a, &  \n   &b)   ",
+            "program",
+            "",
+        };
+
+        for (const auto src : sources) {
+            FortranTokenizer tz(src);
+            const auto tokens = tz.tokenize();
+            const UnwrappedLineParser parser(tokens);
+            const auto lines = parser.parse();
+            const auto table = parser.parse_ranges();
+
+            expect(table.size() == lines.size()) << src;
+            for (std::size_t i = 0; i < std::min(table.size(), lines.size()); ++i) {
+                const auto view = table[i];
+                expect(view.tokens.size() == lines[i].tokens.size()) << src << "line" << i;
+                expect(std::ranges::equal(view.tokens, lines[i].tokens,
+                    [](const Token &a, const Token &b) { return a.text == b.text && a.kind == b.kind; })) << src;
+                for (std::size_t j = 0; j < view.tokens.size(); ++j)
+                    expect(&view.tokens[j] == &*std::ranges::next(view.tokens.begin(), j));
+            }
+        }
+    };
+
+    "range lines view the token vector"_test = [] {
+        FortranTokenizer tz("call f(a, &\n  b)\n");
+        const auto tokens = tz.tokenize();
+        const auto table = UnwrappedLineParser(tokens).parse_ranges();
+
+        expect(table.size() == 2_i);
+        expect(table.splices().size() == 1_u); // the Newline after the '&'
+        const auto line = table[0];
+        expect(&line.tokens.front() == &tokens.front());
+        expect(line.tokens.first_token_is(KeywordId::Call));
+        expect(line.tokens.contains_token("b"));
+        expect(line.tokens.back().kind == TokenKind::Newline);
+    };
 };